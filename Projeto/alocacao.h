@@ -0,0 +1,314 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <atomic>
+#include <new>
+#include <algorithm>
+#include <type_traits>
+#include "paralelo.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+/*
+    -------------
+    [POLITICA DE ALOCACAO: PAGINAS GRANDES E NUMA]
+    -------------
+    As regioes grandes das matrizes (a densa inteira, os blocos do pool de
+    nos) passam por aqui. Com paginas de 4 KB uma densa de 800 MB sao 200
+    mil paginas e o acesso aleatorio do getElemento vive de falta de TLB;
+    em maquina com dois soquetes a pagina fica no no de quem escreveu
+    nela primeiro.
+      - paginas: NENHUMA; TRANSPARENTES (madvise(MADV_HUGEPAGE), o kernel
+        junta em 2 MB quando der); EXPLICITAS (mmap com MAP_HUGETLB, das
+        paginas reservadas em /proc/sys/vm/nr_hugepages).
+      - numa: PADRAO; INTERCALADA (mbind com MPOL_INTERLEAVE em todos os
+        nos, bom quando todas as threads leem tudo); PRIMEIRO_TOQUE (a
+        regiao e zerada em paralelo com a mesma divisao de linhas dos
+        kernels, cada faixa cai no no da thread que vai processa-la).
+    So regioes com pelo menos `minimoBytes` usam a politica. Tudo que nao
+    existe na maquina (sem Linux, sem paginas reservadas, um no so, mbind
+    negado) cai para a alocacao comum sem erro; estatisticasAlocacao()
+    conta o que foi de fato aplicado.
+    A memoria vem do operator new alinhado em 2 MB (entra na contagem de
+    tests/util_medicao.h); so as EXPLICITAS saem de mmap direto e aparecem
+    apenas no RSS.
+    Padrao: MC458_PAGINAS=nenhuma|thp|hugetlb e MC458_NUMA=padrao|
+    intercalada|primeiro_toque no ambiente, ou definirPoliticaAlocacao().
+*/
+
+enum class PaginasGrandes { NENHUMA, TRANSPARENTES, EXPLICITAS };
+enum class PosicaoNuma { PADRAO, INTERCALADA, PRIMEIRO_TOQUE };
+
+static const size_t TAMANHO_PAGINA_GRANDE = (size_t)2 << 20;
+
+struct PoliticaAlocacao {
+    PaginasGrandes paginas = PaginasGrandes::NENHUMA;
+    PosicaoNuma numa = PosicaoNuma::PADRAO;
+    size_t minimoBytes = TAMANHO_PAGINA_GRANDE;
+};
+
+inline bool paginasPorNome(const string& n, PaginasGrandes& p) {
+    if (n == "nenhuma" || n == "0") p = PaginasGrandes::NENHUMA;
+    else if (n == "thp" || n == "transparentes") p = PaginasGrandes::TRANSPARENTES;
+    else if (n == "hugetlb" || n == "explicitas") p = PaginasGrandes::EXPLICITAS;
+    else return false;
+    return true;
+}
+
+inline bool numaPorNome(const string& n, PosicaoNuma& p) {
+    if (n == "padrao" || n == "0") p = PosicaoNuma::PADRAO;
+    else if (n == "intercalada" || n == "interleave") p = PosicaoNuma::INTERCALADA;
+    else if (n == "primeiro_toque" || n == "first_touch") p = PosicaoNuma::PRIMEIRO_TOQUE;
+    else return false;
+    return true;
+}
+
+inline string nomePaginas(PaginasGrandes p) {
+    return p == PaginasGrandes::TRANSPARENTES ? "thp" : p == PaginasGrandes::EXPLICITAS ? "hugetlb" : "nenhuma";
+}
+
+inline string nomeNuma(PosicaoNuma p) {
+    return p == PosicaoNuma::INTERCALADA ? "intercalada" : p == PosicaoNuma::PRIMEIRO_TOQUE ? "primeiro_toque" : "padrao";
+}
+
+// Politica global, lida do ambiente na primeira vez
+inline PoliticaAlocacao& politicaAlocacao() {
+    static PoliticaAlocacao p = []() {
+        PoliticaAlocacao q;
+        if (const char* s = getenv("MC458_PAGINAS")) paginasPorNome(s, q.paginas);
+        if (const char* s = getenv("MC458_NUMA")) numaPorNome(s, q.numa);
+        return q;
+    }();
+    return p;
+}
+
+inline void definirPoliticaAlocacao(const PoliticaAlocacao& p) {
+    politicaAlocacao() = p;
+}
+
+// O que a politica conseguiu aplicar (regioes acima do minimo)
+struct EstatisticasAlocacao {
+    atomic<long long> regioes{0};
+    atomic<long long> transparentes{0};     // madvise aceito
+    atomic<long long> explicitas{0};        // mmap com MAP_HUGETLB
+    atomic<long long> intercaladas{0};      // mbind aceito
+    atomic<long long> recusas{0};           // pedido que caiu para a alocacao comum
+};
+
+inline EstatisticasAlocacao& estatisticasAlocacao() {
+    static EstatisticasAlocacao e;
+    return e;
+}
+
+// Nos de memoria online (/sys/devices/system/node/online, ex.: "0-1");
+// 1 se nao der para saber
+inline int nosNuma() {
+    static int n = []() {
+        ifstream f("/sys/devices/system/node/online");
+        string s;
+        if (!(f >> s)) return 1;
+        int maior = 0;
+        size_t p = 0;
+        while (p < s.size()) {
+            size_t fim = s.find_first_of(",-", p);
+            maior = max(maior, atoi(s.substr(p, fim == string::npos ? string::npos : fim - p).c_str()));
+            if (fim == string::npos) break;
+            p = fim + 1;
+        }
+        return min(maior + 1, 64);
+    }();
+    return n;
+}
+
+// Regiao devolvida por alocarRegiao (o liberar precisa saber de onde veio)
+struct BlocoAlocado {
+    void* p = nullptr;
+    size_t bytes = 0;
+    bool mapeado = false;        // mmap direto (EXPLICITAS)
+    bool alinhado = false;       // operator new alinhado em TAMANHO_PAGINA_GRANDE
+};
+
+// paginas de 4 KB inteiras dentro de [p, p + bytes)
+inline bool paginasInteiras(void* p, size_t bytes, void*& ini, size_t& tam) {
+#ifdef __linux__
+    uintptr_t pag = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t a = ((uintptr_t)p + pag - 1) & ~(pag - 1);
+    uintptr_t b = ((uintptr_t)p + bytes) & ~(pag - 1);
+    if (b <= a) return false;
+    ini = (void*)a;
+    tam = (size_t)(b - a);
+    return true;
+#else
+    (void)p; (void)bytes; (void)ini; (void)tam;
+    return false;
+#endif
+}
+
+inline void intercalarRegiao(void* p, size_t bytes, const PoliticaAlocacao& pol) {
+    if (pol.numa != PosicaoNuma::INTERCALADA) return;
+    int nos = nosNuma();
+    if (nos <= 1) return;
+#if defined(__linux__) && defined(SYS_mbind)
+    void* ini;
+    size_t tam;
+    if (!paginasInteiras(p, bytes, ini, tam)) return;
+    const int MPOL_INTERLEAVE_ = 3;     // <linux/mempolicy.h>, sem depender da libnuma
+    unsigned long mascara = nos >= 64 ? ~0UL : (1UL << nos) - 1;
+    if (syscall(SYS_mbind, ini, tam, MPOL_INTERLEAVE_, &mascara, (unsigned long)nos + 1, 0) == 0)
+        ++estatisticasAlocacao().intercaladas;
+    else
+        ++estatisticasAlocacao().recusas;
+#else
+    (void)p; (void)bytes;
+    ++estatisticasAlocacao().recusas;
+#endif
+}
+
+inline void pedirTransparentes(void* p, size_t bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    void* ini;
+    size_t tam;
+    if (paginasInteiras(p, bytes, ini, tam) && madvise(ini, tam, MADV_HUGEPAGE) == 0) {
+        ++estatisticasAlocacao().transparentes;
+        return;
+    }
+#else
+    (void)p; (void)bytes;
+#endif
+    ++estatisticasAlocacao().recusas;
+}
+
+inline bool mapearExplicitas(size_t bytes, BlocoAlocado& b) {
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    size_t tam = (bytes + TAMANHO_PAGINA_GRANDE - 1) & ~(TAMANHO_PAGINA_GRANDE - 1);
+    void* p = mmap(nullptr, tam, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p == MAP_FAILED) return false;
+    b.p = p;
+    b.bytes = tam;
+    b.mapeado = true;
+    return true;
+#else
+    (void)bytes; (void)b;
+    return false;
+#endif
+}
+
+// Aloca `bytes` (nao inicializados) seguindo a politica atual. EXPLICITAS
+// sem paginas reservadas tenta as TRANSPARENTES. Com a politica padrao (ou
+// regiao pequena) e so o operator new de sempre.
+inline BlocoAlocado alocarRegiao(size_t bytes) {
+    const PoliticaAlocacao& pol = politicaAlocacao();
+    BlocoAlocado b;
+    b.bytes = bytes;
+    bool ativa = pol.paginas != PaginasGrandes::NENHUMA || pol.numa == PosicaoNuma::INTERCALADA;
+    if (!ativa || bytes < pol.minimoBytes || bytes == 0) {
+        b.p = ::operator new(max((size_t)1, bytes));
+        return b;
+    }
+    ++estatisticasAlocacao().regioes;
+    if (pol.paginas == PaginasGrandes::EXPLICITAS) {
+        if (mapearExplicitas(bytes, b)) {
+            ++estatisticasAlocacao().explicitas;
+            intercalarRegiao(b.p, b.bytes, pol);
+            return b;
+        }
+        ++estatisticasAlocacao().recusas;
+    }
+    // alinhada em 2 MB para o kernel poder usar paginas grandes inteiras
+    b.p = ::operator new(bytes, align_val_t(TAMANHO_PAGINA_GRANDE));
+    b.alinhado = true;
+    if (pol.paginas != PaginasGrandes::NENHUMA) pedirTransparentes(b.p, bytes);
+    intercalarRegiao(b.p, bytes, pol);
+    return b;
+}
+
+inline void liberarRegiao(const BlocoAlocado& b) {
+    if (!b.p) return;
+#ifdef __linux__
+    if (b.mapeado) {
+        munmap(b.p, b.bytes);
+        return;
+    }
+#endif
+    if (b.alinhado) ::operator delete(b.p, align_val_t(TAMANHO_PAGINA_GRANDE));
+    else ::operator delete(b.p);
+}
+
+//REGIAO CONTIGUA
+// n elementos zerados numa regiao so (a densa inteira). Com PRIMEIRO_TOQUE
+// o zero (e a copia, no construtor de copia) e escrito em paralelo em
+// `faixas` partes (as linhas), com a divisao de paraleloPara que os
+// kernels usam para as mesmas linhas; senao memset (mmap ja vem zerado).
+template <typename T>
+class RegiaoContigua {
+    static_assert(is_trivially_copyable<T>::value, "RegiaoContigua exige elementos trivialmente copiaveis");
+
+private:
+    BlocoAlocado bloco_;
+    T* dados_ = nullptr;
+    size_t n_ = 0;
+    long long faixas_ = 1;
+
+    // f(inicio, fim) nos elementos, por faixas, na thread que vai usa-las
+    template <typename F>
+    void porFaixas(F f) {
+        if (politicaAlocacao().numa != PosicaoNuma::PRIMEIRO_TOQUE || faixas_ <= 1) {
+            f((size_t)0, n_);
+            return;
+        }
+        size_t porFaixa = n_ / (size_t)faixas_;
+        paraleloPara(faixas_, threadsPara((long long)n_, 1 << 16), [&](long long a, long long b, int) {
+            f((size_t)a * porFaixa, b == faixas_ ? n_ : (size_t)b * porFaixa);
+        });
+    }
+
+    void alocar(size_t n, long long faixas) {
+        n_ = n;
+        faixas_ = max(1LL, faixas);
+        bloco_ = alocarRegiao(n * sizeof(T));
+        dados_ = static_cast<T*>(bloco_.p);
+    }
+
+public:
+    RegiaoContigua() {}
+
+    RegiaoContigua(size_t n, long long faixas) {
+        alocar(n, faixas);
+        if (bloco_.mapeado) return;
+        porFaixas([&](size_t ini, size_t fim) { memset((void*)(dados_ + ini), 0, (fim - ini) * sizeof(T)); });
+    }
+
+    RegiaoContigua(const RegiaoContigua& o) {
+        alocar(o.n_, o.faixas_);
+        porFaixas([&](size_t ini, size_t fim) { memcpy((void*)(dados_ + ini), (const void*)(o.dados_ + ini), (fim - ini) * sizeof(T)); });
+    }
+
+    RegiaoContigua(RegiaoContigua&& o) noexcept { trocar(o); }
+
+    RegiaoContigua& operator=(RegiaoContigua o) noexcept {
+        trocar(o);
+        return *this;
+    }
+
+    ~RegiaoContigua() { liberarRegiao(bloco_); }
+
+    void trocar(RegiaoContigua& o) noexcept {
+        swap(bloco_, o.bloco_);
+        swap(dados_, o.dados_);
+        swap(n_, o.n_);
+        swap(faixas_, o.faixas_);
+    }
+
+    T* dados() { return dados_; }
+    const T* dados() const { return dados_; }
+    size_t tamanho() const { return n_; }
+    size_t bytes() const { return bloco_.mapeado ? bloco_.bytes : n_ * sizeof(T); }
+};
@@ -6,6 +6,7 @@ import os
 
 
 INPUT_FILE = "resultados_funcao_k.csv"
+CARGA = 'uniforme'  # coluna Carga dos CSVs: uniforme, banda, bloco_diagonal, zipf, rmat
 SNS_STYLE = "whitegrid"
 
 COLORS = {
@@ -47,7 +48,9 @@ def plot_combinado_ms():
         print(f"Erro: {INPUT_FILE} não encontrado.")
         return
 
-    df = pd.read_csv(INPUT_FILE)
+    df = pd.read_csv(INPUT_FILE, comment='#')
+    if 'Carga' in df.columns:
+        df = df[df['Carga'] == CARGA]
     
     # Dados de teste com valor -1 são invalidos e linhas corrompidas
     df = df[df['Tempo_ns'] > 0]
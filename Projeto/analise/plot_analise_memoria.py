@@ -5,6 +5,7 @@ import os
 
 
 INPUT_FILE = "resultados_operacoes.csv"
+CARGA = 'uniforme'  # coluna Carga dos CSVs: uniforme, banda, bloco_diagonal, zipf, rmat
 SNS_STYLE = "whitegrid"
 
 PALETTE = {
@@ -12,7 +13,8 @@ PALETTE = {
     'Est1(Hash)': '#1f77b4', # Azul
     'Est2(Tree)': '#2ca02c', # Verde
     'Hash': '#1f77b4',
-    'Tree': '#2ca02c'
+    'Tree': '#2ca02c',
+    'CSR': '#9467bd'         # Roxo
 }
 
 def plot_memoria_unificado():
@@ -21,7 +23,9 @@ def plot_memoria_unificado():
         return
 
     # 1. Carregar Dados
-    df = pd.read_csv(INPUT_FILE)
+    df = pd.read_csv(INPUT_FILE, comment='#')
+    if 'Carga' in df.columns:
+        df = df[df['Carga'] == CARGA]
     
     # Converter para milisegundos e MB
     df['Memoria_MB'] = df['Memoria_Bytes'] / 1e6
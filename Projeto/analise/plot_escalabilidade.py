@@ -0,0 +1,71 @@
+import pandas as pd
+import matplotlib.pyplot as plt
+import seaborn as sns
+import os
+
+INPUT_FILE = "resultados_escalabilidade.csv"
+CARGA = 'uniforme'  # coluna Carga dos CSVs: uniforme, banda, bloco_diagonal, zipf, rmat
+SNS_STYLE = "whitegrid"
+
+PALETTE = {
+    'Densa': '#d62728',      # Vermelho
+    'Est1(Hash)': '#1f77b4', # Azul
+    'Hash': '#1f77b4',
+    'Est2(Tree)': '#2ca02c', # Verde
+    'Tree': '#2ca02c',
+    'CSR': '#9467bd',        # Roxo
+}
+
+def plot_escalabilidade():
+    if not os.path.exists(INPUT_FILE):
+        print(f"Erro: {INPUT_FILE} não encontrado.")
+        return
+
+    df = pd.read_csv(INPUT_FILE, comment='#')
+    if 'Carga' in df.columns:
+        df = df[df['Carga'] == CARGA]
+    if 'Eficiencia' not in df.columns:
+        print("CSV sem coluna de eficiência (rode o test_escalabilidade atual).")
+        return
+
+    # -1 = sem medição ou sem a rodada de 1 thread
+    df = df[(df['Eficiencia'] > 0) & (df['Tempo_ns'] > 0)]
+    coluna_tamanho = 'k' if 'k' in df.columns else 'N'
+
+    # Uma figura por escala: eficiência x threads, um painel por operação
+    for escala in df['Escala'].unique():
+        data_escala = df[df['Escala'] == escala]
+        ops = list(data_escala['Operacao'].unique())
+        if not ops:
+            continue
+
+        fig, eixos = plt.subplots(1, len(ops), figsize=(5 * len(ops), 5), squeeze=False)
+        for eixo, op in zip(eixos[0], ops):
+            data = data_escala[data_escala['Operacao'] == op]
+            for estrutura, grupo in data.groupby('Estrutura'):
+                # escala forte: uma linha por tamanho; fraca: o tamanho cresce com as threads
+                series = [(None, grupo)] if escala == 'fraca' else grupo.groupby(coluna_tamanho)
+                for tamanho, serie in series:
+                    serie = serie.groupby('Threads', as_index=False)['Eficiencia'].median()
+                    rotulo = estrutura if tamanho is None else f'{estrutura} {coluna_tamanho}={tamanho}'
+                    eixo.plot(serie['Threads'], serie['Eficiencia'], marker='o', linewidth=2,
+                              color=PALETTE.get(estrutura), label=rotulo)
+
+            eixo.axhline(1.0, color='gray', linestyle='--', linewidth=1)
+            eixo.set_title(op, fontsize=13, fontweight='bold')
+            eixo.set_xlabel('Threads', fontsize=11)
+            eixo.set_xscale('log', base=2)
+            eixo.set_ylim(bottom=0)
+            eixo.legend(fontsize=8)
+        eixos[0][0].set_ylabel('Eficiência (T1 / (p·Tp))' if escala == 'forte' else 'Eficiência (T1 / Tp)', fontsize=11)
+
+        fig.suptitle(f'Escalabilidade {escala}', fontsize=14, fontweight='bold')
+        fig.tight_layout()
+        filename = f"escalabilidade_{escala}.png"
+        fig.savefig(filename, dpi=300)
+        print(f"Gerado: {filename}")
+        plt.close(fig)
+
+if __name__ == "__main__":
+    sns.set_theme(style=SNS_STYLE)
+    plot_escalabilidade()
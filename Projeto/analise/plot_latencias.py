@@ -0,0 +1,74 @@
+import pandas as pd
+import matplotlib.pyplot as plt
+import seaborn as sns
+import os
+
+INPUT_FILE = "resultados_operacoes.csv"
+CARGA = 'uniforme'  # coluna Carga dos CSVs: uniforme, banda, bloco_diagonal, zipf, rmat
+SNS_STYLE = "whitegrid"
+
+PALETTE = {
+    'Densa': '#d62728',      # Vermelho
+    'Est1(Hash)': '#1f77b4', # Azul
+    'Est2(Tree)': '#2ca02c', # Verde
+}
+
+# percentis gravados pelo test_operacoes (histograma por operacao)
+PERCENTIS = [
+    ('Lat_P50_ns', 'p50', '-'),
+    ('Lat_P99_ns', 'p99', '--'),
+    ('Lat_P999_ns', 'p99.9', ':'),
+    ('Lat_Max_ns', 'max', '-.'),
+]
+
+def plot_latencias():
+    if not os.path.exists(INPUT_FILE):
+        print(f"Erro: {INPUT_FILE} não encontrado.")
+        return
+
+    df = pd.read_csv(INPUT_FILE, comment='#')
+    if 'Carga' in df.columns:
+        df = df[df['Carga'] == CARGA]
+    if 'Lat_P50_ns' not in df.columns:
+        print("CSV sem colunas de latência (rode o test_operacoes atual).")
+        return
+
+    # Só SET e GET têm histograma; -1 = não medido
+    df = df[df['Operacao'].isin(['SET', 'GET']) & (df['Lat_P50_ns'] > 0)]
+
+    for op in df['Operacao'].unique():
+        data_op = df[df['Operacao'] == op]
+
+        # Um gráfico por esparsidade: percentis x N, uma cor por estrutura
+        for esp in sorted(data_op['Esparsidade'].unique()):
+            data = data_op[data_op['Esparsidade'] == esp]
+            if data.empty:
+                continue
+
+            plt.figure(figsize=(8, 6))
+            for estrutura, grupo in data.groupby('Estrutura'):
+                grupo = grupo.sort_values('N')
+                for coluna, nome, estilo in PERCENTIS:
+                    plt.plot(grupo['N'], grupo[coluna], linestyle=estilo, marker='o',
+                             color=PALETTE.get(estrutura), linewidth=2,
+                             label=f'{estrutura} {nome}')
+
+            plt.title(f'Latência por operação: {op} (esparsidade {esp:g})', fontsize=14, fontweight='bold')
+            plt.xlabel('Dimensão da Matriz (N)', fontsize=12)
+            plt.ylabel('Latência (ns)', fontsize=12)
+
+            plt.xscale('log')
+            plt.yscale('log')
+            plt.grid(True, which="minor", ls=":", alpha=0.4)
+            plt.grid(True, which="major", ls="-", alpha=0.8)
+            plt.legend(fontsize=8, ncol=3)
+
+            plt.tight_layout()
+            filename = f"latencia_{op}_esp_{esp:g}.png"
+            plt.savefig(filename, dpi=300)
+            print(f"Gerado: {filename}")
+            plt.close()
+
+if __name__ == "__main__":
+    sns.set_theme(style=SNS_STYLE)
+    plot_latencias()
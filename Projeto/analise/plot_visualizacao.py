@@ -4,6 +4,7 @@ import seaborn as sns
 import os
 
 INPUT_FILE = "resultados_operacoes.csv"
+CARGA = 'uniforme'  # coluna Carga dos CSVs: uniforme, banda, bloco_diagonal, zipf, rmat
 SNS_STYLE = "whitegrid"
 
 PALETTE = {
@@ -11,7 +12,8 @@ PALETTE = {
     'Est1(Hash)': '#1f77b4', # Azul
     'Est2(Tree)': '#2ca02c', # Verde
     'Hash': '#1f77b4',
-    'Tree': '#2ca02c'
+    'Tree': '#2ca02c',
+    'CSR': '#9467bd'         # Roxo
 }
 
 MARKERS = {
@@ -19,7 +21,8 @@ MARKERS = {
     'Est1(Hash)': 'o', 
     'Est2(Tree)': 's',
     'Hash': 'o',
-    'Tree': 's'
+    'Tree': 's',
+    'CSR': 'D'
 }
 
 def plot_comparativo_separado():
@@ -28,7 +31,9 @@ def plot_comparativo_separado():
         return
 
     # 1. Carregar Dados
-    df = pd.read_csv(INPUT_FILE)
+    df = pd.read_csv(INPUT_FILE, comment='#')
+    if 'Carga' in df.columns:
+        df = df[df['Carga'] == CARGA]
     
     # 2. Dados de teste com valor -1 são invalidos
     df = df[df['Tempo_ns'] > 0]
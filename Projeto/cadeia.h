@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <limits>
+#include "produto_esparso.h"
+using namespace std;
+
+/*
+    -------------
+    [PRODUTO EM CADEIA]
+    -------------
+    A0*A1*...*An-1 com a parentizacao escolhida por programacao dinamica
+    (como no problema classico da cadeia de matrizes), mas com custo dado
+    pelos flops estimados a partir das contagens de nao-nulos por linha e
+    coluna de cada fator (estimarProduto). O custo de um intervalo soma os
+    flops de cada produto e o nnz estimado de cada intermediario gerado.
+*/
+
+struct PlanoCadeia {
+    int n = 0;
+    vector<vector<int>> divisao;       // divisao[i][j]: ultimo fator do lado esquerdo
+    vector<vector<double>> custo;      // custo estimado do intervalo [i, j]
+    vector<vector<EstatisticasPadrao>> estimativa;
+
+    double custoTotal() const { return n == 0 ? 0.0 : custo[0][n - 1]; }
+    double nnzEstimado() const { return n == 0 ? 0.0 : estimativa[0][n - 1].nnz; }
+
+    // ex.: "((A0*A1)*A2)"
+    string parentizacao() const { return n == 0 ? string() : descrever(0, n - 1); }
+
+private:
+    string descrever(int i, int j) const {
+        if (i == j) return "A" + to_string(i);
+        int s = divisao[i][j];
+        return "(" + descrever(i, s) + "*" + descrever(s + 1, j) + ")";
+    }
+};
+
+inline PlanoCadeia planejarCadeia(const vector<EstatisticasPadrao>& fatores) {
+    PlanoCadeia P;
+    int n = (int)fatores.size();
+    P.n = n;
+    P.divisao.assign(n, vector<int>(n, -1));
+    P.custo.assign(n, vector<double>(n, 0.0));
+    P.estimativa.assign(n, vector<EstatisticasPadrao>(n));
+    for (int i = 0; i < n; ++i) P.estimativa[i][i] = fatores[i];
+
+    for (int tam = 2; tam <= n; ++tam) {
+        for (int i = 0; i + tam - 1 < n; ++i) {
+            int j = i + tam - 1;
+            P.custo[i][j] = numeric_limits<double>::infinity();
+            for (int s = i; s < j; ++s) {
+                const EstatisticasPadrao& E = P.estimativa[i][s];
+                const EstatisticasPadrao& D = P.estimativa[s + 1][j];
+                double flops = estimarFlops(E, D);
+                EstatisticasPadrao R = estimarProduto(E, D);
+                double c = P.custo[i][s] + P.custo[s + 1][j] + flops + R.nnz;
+                if (c < P.custo[i][j]) {
+                    P.custo[i][j] = c;
+                    P.divisao[i][j] = s;
+                    P.estimativa[i][j] = std::move(R);
+                }
+            }
+        }
+    }
+    return P;
+}
+
+template <typename Matriz>
+Matriz executarPlano(const vector<const Matriz*>& fatores, const PlanoCadeia& P, int i, int j) {
+    if (i == j) return fatores[i]->clonar();
+    int s = P.divisao[i][j];
+
+    // fatores originais sao usados direto; so os intermediarios sao materializados
+    Matriz esquerda(0, 0), direita(0, 0);
+    const Matriz* E = fatores[i];
+    const Matriz* D = fatores[j];
+    if (s > i) { esquerda = executarPlano(fatores, P, i, s); E = &esquerda; }
+    if (s + 1 < j) { direita = executarPlano(fatores, P, s + 1, j); D = &direita; }
+    return E->multiplicar(*D);
+}
+
+//MULTIPLICACAO EM CADEIA
+// Funciona com MatrizEsparsaHashDup e MatrizEsparsaTreeDup (qualquer classe
+// com estatisticas(), multiplicar() e clonar()).
+template <typename Matriz>
+Matriz multiplicarCadeia(const vector<const Matriz*>& fatores, PlanoCadeia* planoUsado = nullptr) {
+    vector<EstatisticasPadrao> stats;
+    stats.reserve(fatores.size());
+    for (const Matriz* M : fatores) stats.push_back(M->estatisticas());
+
+    PlanoCadeia P = planejarCadeia(stats);
+    if (planoUsado) *planoUsado = P;
+    if (fatores.empty()) return Matriz(0, 0);
+    return executarPlano(fatores, P, 0, (int)fatores.size() - 1);
+}
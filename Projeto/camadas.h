@@ -0,0 +1,331 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <future>
+#include <memory>
+#include <shared_mutex>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <chrono>
+#include "csr.h"
+#include "paralelo.h"
+#include "uso_memoria.h"
+using namespace std;
+
+/*
+    -------------
+    [MATRIZ EM CAMADAS (DELTA + BASE COMPRIMIDA)]
+    -------------
+    Escritas e produtos querem formatos opostos: as listas da HashDup aceitam
+    set em O(1) mas percorrem ponteiros no produto; a CSR multiplica em
+    vetores contiguos mas nao aceita insercao. Aqui as duas coisas ficam em
+    camadas, como numa LSM:
+      - delta: tabela hash (i,j) -> valor, sem ordem, so recebe escritas
+        (0.0 fica guardado como remocao);
+      - congelado: um delta fechado que esta sendo compactado em segundo plano;
+      - base: MatrizCSR, so de leitura entre compactacoes.
+    getElemento consulta delta, congelado e base, nessa ordem. A compactacao
+    ordena o delta por (linha, coluna) e intercala cada linha com a da base
+    (em paralelo por faixas de linhas, como MatrizCSR::combinar). Ela dispara
+    quando o delta passa do limite -- um quarto da base, no minimo
+    LIMITE_MINIMO_DELTA, entao cada escrita paga O(1) amortizado -- ou a mao.
+    Com segundo plano ligado a compactacao roda numa std::async sobre o delta
+    congelado enquanto novas escritas vao para um delta novo; a base nova e
+    instalada na proxima operacao que encontrar a tarefa pronta.
+    Operacoes sobre a matriz inteira (produto, soma, SpMV, paraCSR) compactam
+    antes e usam os kernels da CSR. Compactar nao muda o conteudo, por isso
+    as camadas sao mutable e essas operacoes continuam const; a compactacao
+    feita por elas e exclusiva (trava) e as leituras sao compartilhadas,
+    entao leituras const concorrentes sao seguras como nas outras classes.
+    A base e sempre uma CSR, e nao a HashDup/TreeDup envolvida: a base so e
+    lida entre compactacoes, e o formato que o produto e o SpMV querem e o
+    contiguo; HashDup, TreeDup e Densa entram pelo construtor (paraCSR).
+    A base fica num shared_ptr: a compactacao troca o ponteiro e quem ja
+    pegou a base anterior (tarefa em segundo plano, operacao em andamento)
+    continua com ela.
+*/
+
+class MatrizEmCamadas {
+private:
+    int linhas_, colunas_;
+    mutable shared_ptr<MatrizCSR> base_;
+    mutable unordered_map<uint64_t, double> delta_;
+    mutable unordered_map<uint64_t, double> congelado_;
+    size_t limiteDelta_ = 0;            // 0 = automatico (base/4)
+    bool segundoPlano_ = false;
+    // exclusiva para compactar a partir dos metodos const, compartilhada nas leituras
+    mutable shared_mutex trava_;
+    // declarada por ultimo: e destruida (e esperada) antes das camadas que usa
+    mutable future<MatrizCSR> compactando_;
+
+    static inline uint64_t chave(int i, int j) {
+        return ((uint64_t)(uint32_t)i << 32) | (uint32_t)j;
+    }
+
+    // base 0x0 compartilhada pelas matrizes vazias e pelas que foram movidas
+    // (o movimento e noexcept: so copia este ponteiro, sem alocar)
+    static const shared_ptr<MatrizCSR>& baseVazia() {
+        static const shared_ptr<MatrizCSR> vazia = make_shared<MatrizCSR>(0, 0);
+        return vazia;
+    }
+
+    size_t limiteAtual() const {
+        if (limiteDelta_) return limiteDelta_;
+        return max(LIMITE_MINIMO_DELTA, base_->getNaoNulos() / 4);
+    }
+
+    // Intercala as escritas (ultimas de cada posicao) com as linhas da base.
+    // Valor do delta substitui o da base; 0.0 remove.
+    static MatrizCSR mesclar(const MatrizCSR& base, const unordered_map<uint64_t, double>& delta) {
+        int L = base.getLinhas();
+        vector<pair<uint64_t, double>> d(delta.begin(), delta.end());
+        ordenarParalelo(d, [](const pair<uint64_t, double>& a, const pair<uint64_t, double>& b) {
+            return a.first < b.first;
+        });
+        vector<long long> inicioDelta((size_t)max(0, L) + 1, 0);
+        for (auto const& e : d) ++inicioDelta[(e.first >> 32) + 1];
+        for (int i = 0; i < L; ++i) inicioDelta[i + 1] += inicioDelta[i];
+
+        const vector<long long>& ib = base.inicio();
+        const vector<int>& cb = base.colunasIdx();
+        const vector<double>& vb = base.valores();
+        auto mesclarLinha = [&](int i, auto emitir) {
+            long long p = ib[i], pf = ib[i + 1], q = inicioDelta[i], qf = inicioDelta[i + 1];
+            while (p < pf || q < qf) {
+                int jd = q < qf ? (int)(uint32_t)d[q].first : numeric_limits<int>::max();
+                if (p < pf && cb[p] < jd) { emitir(cb[p], vb[p]); ++p; continue; }
+                if (p < pf && cb[p] == jd) ++p;
+                if (d[q].second != 0.0) emitir(jd, d[q].second);
+                ++q;
+            }
+        };
+
+        int threads = threadsPara((long long)(vb.size() + d.size()), 1 << 15);
+        vector<long long> inicio((size_t)max(0, L) + 1, 0);
+        paraleloPara(L, threads, [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                if (inicioDelta[i] == inicioDelta[i + 1]) { inicio[i + 1] = ib[i + 1] - ib[i]; continue; }
+                long long n = 0;
+                mesclarLinha((int)i, [&](int, double) { ++n; });
+                inicio[i + 1] = n;
+            }
+        });
+        for (int i = 0; i < L; ++i) inicio[i + 1] += inicio[i];
+
+        long long nnz = inicio[max(0, L)];
+        vector<int> cols((size_t)nnz);
+        vector<double> vals((size_t)nnz);
+        paraleloPara(L, threads, [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                long long w = inicio[i];
+                if (inicioDelta[i] == inicioDelta[i + 1]) {
+                    copy(cb.begin() + ib[i], cb.begin() + ib[i + 1], cols.begin() + w);
+                    copy(vb.begin() + ib[i], vb.begin() + ib[i + 1], vals.begin() + w);
+                    continue;
+                }
+                mesclarLinha((int)i, [&](int j, double v) {
+                    cols[w] = j;
+                    vals[w++] = v;
+                });
+            }
+        });
+        return MatrizCSR(L, base.getColunas(), std::move(inicio), std::move(cols), std::move(vals));
+    }
+
+    bool compactandoEmSegundoPlano() const { return compactando_.valid(); }
+
+    // instala a base da compactacao em segundo plano se ja terminou (ou
+    // espera por ela, com esperar=true). Chamada com a trava exclusiva ou
+    // de um metodo nao const.
+    void concluirCompactacao(bool esperar) const {
+        if (!compactando_.valid()) return;
+        if (!esperar && compactando_.wait_for(chrono::seconds(0)) != future_status::ready) return;
+        base_ = make_shared<MatrizCSR>(compactando_.get());
+        unordered_map<uint64_t, double>().swap(congelado_);
+    }
+
+    void iniciarCompactacaoEmSegundoPlano() {
+        concluirCompactacao(true);
+        if (delta_.empty()) return;
+        congelado_.swap(delta_);
+        shared_ptr<const MatrizCSR> base = base_;
+        const unordered_map<uint64_t, double>* congelado = &congelado_;
+        compactando_ = async(launch::async, [base, congelado]() { return mesclar(*base, *congelado); });
+    }
+
+    // compactar() com a trava exclusiva ja tomada
+    void compactarTravado() const {
+        concluirCompactacao(true);
+        if (delta_.empty()) return;
+        base_ = make_shared<MatrizCSR>(mesclar(*base_, delta_));
+        unordered_map<uint64_t, double>().swap(delta_);
+    }
+
+    // base compactada; o ponteiro segura a base mesmo que outra a substitua
+    shared_ptr<const MatrizCSR> baseAtual() const {
+        compactar();
+        shared_lock<shared_mutex> leitura(trava_);
+        return base_;
+    }
+
+    // Toma as camadas de `o` (que ja terminou a compactacao em segundo
+    // plano) e deixa `o` como uma matriz 0x0 valida
+    void moverDe(MatrizEmCamadas& o) noexcept {
+        o.concluirCompactacao(true);
+        linhas_ = o.linhas_;
+        colunas_ = o.colunas_;
+        base_ = std::move(o.base_);
+        delta_ = std::move(o.delta_);
+        limiteDelta_ = o.limiteDelta_;
+        segundoPlano_ = o.segundoPlano_;
+        o.base_ = baseVazia();
+        o.delta_.clear();
+        o.linhas_ = o.colunas_ = 0;
+    }
+
+public:
+    // minimo do limite automatico: abaixo disso a intercalacao nao compensa
+    static constexpr size_t LIMITE_MINIMO_DELTA = 1 << 16;
+
+    MatrizEmCamadas(int linhas, int colunas)
+        : linhas_(linhas), colunas_(colunas), base_(make_shared<MatrizCSR>(linhas, colunas)) {
+        baseVazia();    // criada aqui, fora do movimento noexcept
+    }
+
+    // base pronta (por exemplo a saida de um produto), delta vazio
+    explicit MatrizEmCamadas(MatrizCSR base)
+        : linhas_(base.getLinhas()), colunas_(base.getColunas()), base_(make_shared<MatrizCSR>(std::move(base))) {
+        baseVazia();
+    }
+
+    // Qualquer formato com paraCSR() (MatrizDensa, HashDup, TreeDup)
+    template <typename Matriz, typename = decltype(declval<const Matriz&>().paraCSR())>
+    explicit MatrizEmCamadas(const Matriz& M) : MatrizEmCamadas(M.paraCSR()) {}
+
+    ~MatrizEmCamadas() { concluirCompactacao(true); }
+
+    // copias implicitas sao proibidas, como nas outras esparsas; use clonar()
+    MatrizEmCamadas(const MatrizEmCamadas&) = delete;
+    MatrizEmCamadas& operator=(const MatrizEmCamadas&) = delete;
+
+    // a tarefa em segundo plano aponta para as camadas do objeto de origem:
+    // termina antes de mover
+    MatrizEmCamadas(MatrizEmCamadas&& o) noexcept
+        : linhas_(0), colunas_(0), base_(baseVazia()) {
+        moverDe(o);
+    }
+    MatrizEmCamadas& operator=(MatrizEmCamadas&& o) noexcept {
+        if (this == &o) return *this;
+        concluirCompactacao(true);
+        moverDe(o);
+        return *this;
+    }
+
+    MatrizEmCamadas clonar() const {
+        MatrizCSR copia = *baseAtual();
+        MatrizEmCamadas C(std::move(copia));
+        C.limiteDelta_ = limiteDelta_;
+        C.segundoPlano_ = segundoPlano_;
+        return C;
+    }
+
+    int getLinhas() const { return linhas_; }
+    int getColunas() const { return colunas_; }
+
+    //CONFIGURACAO DA COMPACTACAO
+    // limite de escritas pendentes no delta (0 = automatico)
+    void definirLimiteDelta(size_t limite) { limiteDelta_ = limite; }
+    void definirCompactacaoEmSegundoPlano(bool ligado) { segundoPlano_ = ligado; }
+
+    // escritas ainda fora da base (delta + congelado)
+    size_t pendentes() const {
+        shared_lock<shared_mutex> leitura(trava_);
+        return delta_.size() + congelado_.size();
+    }
+
+    //INSERIR / ATUALIZAR / REMOVER
+    // So escreve no delta; a base nao e consultada
+    void set(int i, int j, double valor) {
+        if (i < 0 || i >= linhas_ || j < 0 || j >= colunas_) return;
+        delta_[chave(i, j)] = valor;
+        if (delta_.size() < limiteAtual()) return;
+        if (segundoPlano_) {
+            concluirCompactacao(false);
+            if (!compactandoEmSegundoPlano()) iniciarCompactacaoEmSegundoPlano();
+        } else {
+            compactar();
+        }
+    }
+
+    //ACESSAR ELEMENTO: delta, congelado, base
+    double getElemento(int i, int j) const {
+        if (i < 0 || i >= linhas_ || j < 0 || j >= colunas_) return 0.0;
+        uint64_t k = chave(i, j);
+        shared_lock<shared_mutex> leitura(trava_);
+        if (!delta_.empty()) {
+            auto it = delta_.find(k);
+            if (it != delta_.end()) return it->second;
+        }
+        if (!congelado_.empty()) {
+            auto it = congelado_.find(k);
+            if (it != congelado_.end()) return it->second;
+        }
+        return base_->getElemento(i, j);
+    }
+
+    //COMPACTACAO
+    // Junta o que estiver pendente na base (espera a tarefa em segundo plano).
+    // Sem nada pendente so a trava compartilhada e tomada.
+    void compactar() const {
+        {
+            shared_lock<shared_mutex> leitura(trava_);
+            if (delta_.empty() && !compactando_.valid()) return;
+        }
+        unique_lock<shared_mutex> escrita(trava_);
+        compactarTravado();
+    }
+
+    // base atual, depois de compactar (so muda com uma escrita nova)
+    const MatrizCSR& base() const { return *baseAtual(); }
+
+    // nnz exato: compacta antes
+    size_t getNaoNulos() const { return baseAtual()->getNaoNulos(); }
+
+    //OPERACOES (na base compactada, com os kernels da CSR)
+    MatrizEmCamadas somar(const MatrizEmCamadas& B, const Poda& poda = Poda()) const {
+        return MatrizEmCamadas(baseAtual()->somar(*B.baseAtual(), poda));
+    }
+
+    MatrizEmCamadas multiplicar(const MatrizEmCamadas& B, const Poda& poda = Poda()) const {
+        return MatrizEmCamadas(baseAtual()->multiplicar(*B.baseAtual(), poda));
+    }
+
+    // compacta e poda a base (ver MatrizCSR::podar); uma base ainda
+    // compartilhada (a 0x0 comum) e copiada antes
+    size_t podar(const Poda& poda) {
+        compactar();
+        if (base_.use_count() > 1) base_ = make_shared<MatrizCSR>(*base_);
+        return base_->podar(poda);
+    }
+    size_t podar(double tolerancia) { return podar(Poda(tolerancia)); }
+
+    vector<double> multiplicarVetor(const vector<double>& x) const {
+        return baseAtual()->multiplicarVetor(x);
+    }
+
+    MatrizCSR paraCSR() const { return *baseAtual(); }
+
+    template <typename F>
+    void paraCadaElemento(F f) const { baseAtual()->paraCadaElemento(f); }
+
+    //USO DE MEMORIA: base + tabelas das escritas pendentes
+    UsoMemoria usoMemoria() const {
+        shared_lock<shared_mutex> leitura(trava_);
+        UsoMemoria u = base_->usoMemoria();
+        u.objeto = sizeof(*this);
+        u.tabelas = bytesTabelaHash(delta_) + bytesTabelaHash(congelado_);
+        return u;
+    }
+};
@@ -0,0 +1,357 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "paralelo.h"
+#include "uso_memoria.h"
+#include "produto_esparso.h"
+#include "poda.h"
+using namespace std;
+
+/*
+    -------------
+    [MATRIZ CSR (COMPRIMIDA POR LINHAS)]
+    -------------
+    Uma orientacao so: inicio[i]..inicio[i+1] sao as posicoes da linha i em
+    colunasIdx/valores, com as colunas em ordem crescente. Ocupa
+    (linhas+1)*8 + nnz*12 bytes, contra as duas copias completas que HashDup
+    e TreeDup mantem para o transpor() O(1). A transposta aqui e explicita,
+    feita por contagem (ver transposta()).
+*/
+
+class MatrizCSR {
+private:
+    int linhas_, colunas_;
+    vector<long long> inicio_;
+    vector<int> colunasIdx_;
+    vector<double> valores_;
+
+    // Linhas escritas no comeco das suas faixas com `tamanho[i]` elementos
+    // (o resto da faixa sobrou): junta tudo e refaz o inicio
+    static void fecharFaixas(int linhas, vector<long long>& inicio, const vector<long long>& tamanho,
+                             vector<int>& cols, vector<double>& vals) {
+        long long d = 0;
+        bool buracos = false;
+        for (int i = 0; i < linhas && !buracos; ++i) buracos = tamanho[i] != inicio[i + 1] - inicio[i];
+        if (!buracos) return;
+        for (int i = 0; i < linhas; ++i) {
+            long long p = inicio[i];
+            inicio[i] = d;
+            for (long long r = 0; r < tamanho[i]; ++r, ++d) {
+                cols[d] = cols[p + r];
+                vals[d] = vals[p + r];
+            }
+        }
+        inicio[max(0, linhas)] = d;
+        cols.resize((size_t)d);
+        vals.resize((size_t)d);
+    }
+
+public:
+    MatrizCSR(int linhas, int colunas)
+        : linhas_(linhas), colunas_(colunas), inicio_((size_t)max(0, linhas) + 1, 0) {}
+
+    // Monta a partir dos vetores ja no formato (colunas ordenadas dentro de cada linha)
+    MatrizCSR(int linhas, int colunas, vector<long long> inicio, vector<int> colunasIdx, vector<double> valores)
+        : linhas_(linhas), colunas_(colunas), inicio_(std::move(inicio)),
+          colunasIdx_(std::move(colunasIdx)), valores_(std::move(valores)) {}
+
+    int getLinhas() const { return linhas_; }
+    int getColunas() const { return colunas_; }
+    size_t getNaoNulos() const { return valores_.size(); }
+
+    const vector<long long>& inicio() const { return inicio_; }
+    const vector<int>& colunasIdx() const { return colunasIdx_; }
+    const vector<double>& valores() const { return valores_; }
+
+    //USO DE MEMORIA (O(1))
+    UsoMemoria usoMemoria() const {
+        UsoMemoria u;
+        u.objeto = sizeof(*this);
+        u.cabecas = bytesVetor(inicio_);
+        u.contiguo = bytesVetor(colunasIdx_) + bytesVetor(valores_);
+        u.valores = valores_.size() * sizeof(double);
+        return u;
+    }
+
+    //ACESSAR ELEMENTO (busca binaria na linha)
+    double getElemento(int i, int j) const {
+        if (i < 0 || i >= linhas_ || j < 0 || j >= colunas_) return 0.0;
+        auto ini = colunasIdx_.begin() + inicio_[i];
+        auto fim = colunasIdx_.begin() + inicio_[i + 1];
+        auto it = lower_bound(ini, fim, j);
+        if (it == fim || *it != j) return 0.0;
+        return valores_[it - colunasIdx_.begin()];
+    }
+
+    int nnzNaLinha(int i) const {
+        return (int)(inicio_[i + 1] - inicio_[i]);
+    }
+
+    //PERCORRER ELEMENTOS
+    template <typename F>
+    void paraCadaNaLinha(int i, F f) const {
+        if (i < 0 || i >= linhas_) return;
+        for (long long p = inicio_[i]; p < inicio_[i + 1]; ++p) f(colunasIdx_[p], valores_[p]);
+    }
+
+    template <typename F>
+    void paraCadaLinhaNaoVazia(F f) const {
+        for (int i = 0; i < linhas_; ++i)
+            if (inicio_[i + 1] > inicio_[i]) f(i);
+    }
+
+    template <typename F>
+    void paraCadaElemento(F f) const {
+        for (int i = 0; i < linhas_; ++i)
+            for (long long p = inicio_[i]; p < inicio_[i + 1]; ++p) f(i, colunasIdx_[p], valores_[p]);
+    }
+
+    //OPERACOES ELEMENTO A ELEMENTO
+    // Intercalacao das linhas ordenadas de A e B: c(i,j) = op(a(i,j), b(i,j)).
+    // Na intersecao so as posicoes presentes nas duas entram (produto de
+    // Hadamard); na uniao a posicao que falta vale 0 (maximo/minimo).
+    // Resultados zero (ou abaixo da `poda`) nao sao guardados. Duas passadas
+    // em paralelo por faixas de linhas: conta o tamanho de cada linha, depois
+    // escreve na faixa dela.
+    template <typename Op>
+    MatrizCSR combinar(const MatrizCSR& B, bool uniao, Op op, const Poda& poda = Poda()) const {
+        const vector<long long>& ib = B.inicio_;
+        const vector<int>& cb = B.colunasIdx_;
+        const vector<double>& vb = B.valores_;
+        auto mesclar = [&](int i, auto emitir) {
+            long long p = inicio_[i], pf = inicio_[i + 1], q = ib[i], qf = ib[i + 1];
+            while (p < pf && q < qf) {
+                if (colunasIdx_[p] == cb[q]) { emitir(colunasIdx_[p], op(valores_[p], vb[q])); ++p; ++q; }
+                else if (colunasIdx_[p] < cb[q]) { if (uniao) emitir(colunasIdx_[p], op(valores_[p], 0.0)); ++p; }
+                else { if (uniao) emitir(cb[q], op(0.0, vb[q])); ++q; }
+            }
+            if (!uniao) return;
+            for (; p < pf; ++p) emitir(colunasIdx_[p], op(valores_[p], 0.0));
+            for (; q < qf; ++q) emitir(cb[q], op(0.0, vb[q]));
+        };
+
+        int threads = threadsPara((long long)(valores_.size() + vb.size()), 1 << 15);
+        vector<long long> inicio((size_t)max(0, linhas_) + 1, 0);
+        paraleloPara(linhas_, threads, [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                long long n = 0;
+                mesclar((int)i, [&](int, double v) { if (poda.manter(v)) ++n; });
+                inicio[i + 1] = poda.limitaLinha() ? min(n, (long long)poda.maioresPorLinha) : n;
+            }
+        });
+        for (int i = 0; i < linhas_; ++i) inicio[i + 1] += inicio[i];
+
+        long long nnz = inicio[max(0, linhas_)];
+        vector<int> cols((size_t)nnz);
+        vector<double> vals((size_t)nnz);
+        paraleloPara(linhas_, threads, [&](long long ini, long long fim, int) {
+            vector<pair<int, double>> linha;
+            for (long long i = ini; i < fim; ++i) {
+                long long d = inicio[i];
+                if (!poda.limitaLinha()) {
+                    mesclar((int)i, [&](int j, double v) {
+                        if (!poda.manter(v)) return;
+                        cols[d] = j;
+                        vals[d++] = v;
+                    });
+                    continue;
+                }
+                linha.clear();
+                mesclar((int)i, [&](int j, double v) { if (poda.manter(v)) linha.push_back(make_pair(j, v)); });
+                poda.limitar(linha);
+                for (auto const& e : linha) {
+                    cols[d] = e.first;
+                    vals[d++] = e.second;
+                }
+            }
+        });
+        return MatrizCSR(linhas_, colunas_, std::move(inicio), std::move(cols), std::move(vals));
+    }
+
+    MatrizCSR produtoHadamard(const MatrizCSR& B) const {
+        return combinar(B, false, [](double a, double b) { return a * b; });
+    }
+    MatrizCSR maximoElemento(const MatrizCSR& B) const {
+        return combinar(B, true, [](double a, double b) { return max(a, b); });
+    }
+    MatrizCSR minimoElemento(const MatrizCSR& B) const {
+        return combinar(B, true, [](double a, double b) { return min(a, b); });
+    }
+
+    //SOMA: uniao das linhas, cancelamentos (e o que a poda descartar) nao sao guardados
+    MatrizCSR somar(const MatrizCSR& B, const Poda& poda = Poda()) const {
+        return combinar(B, true, [](double a, double b) { return a + b; }, poda);
+    }
+
+    //MULTIPLICACAO DE MATRIZES (Gustavson por linhas)
+    // Mesmo esquema de duas passadas do combinar: a primeira conta as colunas
+    // distintas de cada linha de C, a segunda acumula e escreve na faixa da
+    // linha. Um AcumuladorLinha por thread; zeros do cancelamento e o que a
+    // `poda` descartar nao entram (as sobras no fim das faixas sao fechadas).
+    MatrizCSR multiplicar(const MatrizCSR& B, const Poda& poda = Poda()) const {
+        const vector<long long>& ib = B.inicio_;
+        const vector<int>& cb = B.colunasIdx_;
+        const vector<double>& vb = B.valores_;
+        long long trabalho = (long long)(valores_.size() + vb.size());
+        int threads = threadsPara(trabalho, 1 << 14);
+
+        vector<long long> inicio((size_t)max(0, linhas_) + 1, 0);
+        paraleloPara(linhas_, threads, [&](long long ini, long long fim, int) {
+            AcumuladorLinha acc(B.colunas_, trabalho);
+            vector<int> colunas;
+            for (long long i = ini; i < fim; ++i) {
+                if (inicio_[i] == inicio_[i + 1]) continue;
+                for (long long p = inicio_[i]; p < inicio_[i + 1]; ++p) {
+                    int k = colunasIdx_[p];
+                    for (long long q = ib[k]; q < ib[k + 1]; ++q) acc.marcar(cb[q]);
+                }
+                colunas.clear();
+                acc.extrairColunas(colunas);
+                inicio[i + 1] = (long long)colunas.size();
+            }
+        });
+        for (int i = 0; i < linhas_; ++i) inicio[i + 1] += inicio[i];
+
+        long long nnz = inicio[max(0, linhas_)];
+        vector<int> cols((size_t)nnz);
+        vector<double> vals((size_t)nnz);
+        vector<long long> tamanho((size_t)max(0, linhas_), 0);
+        paraleloPara(linhas_, threads, [&](long long ini, long long fim, int) {
+            AcumuladorLinha acc(B.colunas_, trabalho);
+            vector<int> colunas;
+            vector<pair<int, double>> linha;
+            for (long long i = ini; i < fim; ++i) {
+                if (inicio[i] == inicio[i + 1]) continue;
+                for (long long p = inicio_[i]; p < inicio_[i + 1]; ++p) {
+                    int k = colunasIdx_[p];
+                    for (long long q = ib[k]; q < ib[k + 1]; ++q) acc.marcar(cb[q]);
+                }
+                colunas.clear();
+                acc.extrairColunas(colunas);
+                for (long long p = inicio_[i]; p < inicio_[i + 1]; ++p) {
+                    int k = colunasIdx_[p];
+                    double a = valores_[p];
+                    for (long long q = ib[k]; q < ib[k + 1]; ++q) acc.somar(cb[q], a * vb[q]);
+                }
+                long long d = inicio[i];
+                linha.clear();
+                for (int j : colunas) {
+                    double v = acc.retirar(j);
+                    if (!poda.manter(v)) continue;
+                    if (poda.limitaLinha()) { linha.push_back(make_pair(j, v)); continue; }
+                    cols[d] = j;
+                    vals[d++] = v;
+                }
+                poda.limitar(linha);
+                for (auto const& e : linha) {
+                    cols[d] = e.first;
+                    vals[d++] = e.second;
+                }
+                acc.limparValores();
+                tamanho[i] = d - inicio[i];
+            }
+        });
+        fecharFaixas(linhas_, inicio, tamanho, cols, vals);
+        return MatrizCSR(linhas_, B.colunas_, std::move(inicio), std::move(cols), std::move(vals));
+    }
+
+    //PODA (uma passada, em paralelo por faixas de linhas)
+    // Sai o que a `poda` descarta; os vetores sao reescritos compactos (a
+    // capacidade sobrando e devolvida). Devolve quantos nao-nulos sairam.
+    size_t podar(const Poda& poda) {
+        size_t antes = valores_.size();
+        vector<long long> tamanho((size_t)max(0, linhas_), 0);
+        paraleloPara(linhas_, threadsPara((long long)antes, 1 << 15), [&](long long ini, long long fim, int) {
+            vector<pair<int, double>> linha;
+            for (long long i = ini; i < fim; ++i) {
+                long long d = inicio_[i];
+                linha.clear();
+                for (long long p = inicio_[i]; p < inicio_[i + 1]; ++p) {
+                    if (!poda.manter(valores_[p])) continue;
+                    if (poda.limitaLinha()) { linha.push_back(make_pair(colunasIdx_[p], valores_[p])); continue; }
+                    colunasIdx_[d] = colunasIdx_[p];
+                    valores_[d++] = valores_[p];
+                }
+                poda.limitar(linha);
+                for (auto const& e : linha) {
+                    colunasIdx_[d] = e.first;
+                    valores_[d++] = e.second;
+                }
+                tamanho[i] = d - inicio_[i];
+            }
+        });
+        fecharFaixas(linhas_, inicio_, tamanho, colunasIdx_, valores_);
+        colunasIdx_.shrink_to_fit();
+        valores_.shrink_to_fit();
+        return antes - valores_.size();
+    }
+    size_t podar(double tolerancia) { return podar(Poda(tolerancia)); }
+
+    //MULTIPLICACAO POR VETOR (SpMV): y = A*x, em paralelo por faixas de linhas
+    vector<double> multiplicarVetor(const vector<double>& x) const {
+        vector<double> y((size_t)max(0, linhas_), 0.0);
+        paraleloPara(linhas_, threadsPara((long long)valores_.size(), 1 << 15), [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                double soma = 0.0;
+                for (long long p = inicio_[i]; p < inicio_[i + 1]; ++p) soma += valores_[p] * x[colunasIdx_[p]];
+                y[i] = soma;
+            }
+        });
+        return y;
+    }
+
+    //TRANSPOSTA EXPLICITA
+    // Ordenacao por contagem em duas passadas, em paralelo por faixas de linhas:
+    //   1) cada thread conta quantos elementos da sua faixa caem em cada coluna;
+    //   2) soma de prefixos (coluna, thread) da a posicao de escrita de cada thread;
+    //   3) cada thread espalha a sua faixa.
+    // Como as faixas sao percorridas em ordem de linha, as linhas dentro de cada
+    // coluna (linhas da transposta) saem ordenadas e o resultado e o mesmo para
+    // qualquer numero de threads.
+    MatrizCSR transposta(int threads = 0) const {
+        long long nnz = (long long)valores_.size();
+        if (threads <= 0) threads = threadsPara(nnz, 1 << 16);
+        // um histograma de `colunas_` posicoes por thread: so vale se nnz compensar
+        threads = (int)max(1LL, min((long long)threads, nnz / max(1LL, (long long)colunas_ / 4) + 1));
+
+        vector<vector<long long>> cont(threads, vector<long long>((size_t)colunas_ + 1, 0));
+        vector<int> faixa(threads + 1);
+        for (int t = 0; t <= threads; ++t) faixa[t] = (int)((long long)linhas_ * t / threads);
+
+        paraleloPara(threads, threads, [&](long long t0, long long t1, int) {
+            for (long long t = t0; t < t1; ++t) {
+                vector<long long>& c = cont[t];
+                for (long long p = inicio_[faixa[t]]; p < inicio_[faixa[t + 1]]; ++p) ++c[colunasIdx_[p]];
+            }
+        });
+
+        vector<long long> inicioT((size_t)colunas_ + 1, 0);
+        long long acumulado = 0;
+        for (int j = 0; j < colunas_; ++j) {
+            inicioT[j] = acumulado;
+            for (int t = 0; t < threads; ++t) {
+                long long q = cont[t][j];
+                cont[t][j] = acumulado;
+                acumulado += q;
+            }
+        }
+        inicioT[colunas_] = acumulado;
+
+        vector<int> colunasT((size_t)nnz);
+        vector<double> valoresT((size_t)nnz);
+        paraleloPara(threads, threads, [&](long long t0, long long t1, int) {
+            for (long long t = t0; t < t1; ++t) {
+                vector<long long>& pos = cont[t];
+                for (int i = faixa[t]; i < faixa[t + 1]; ++i) {
+                    for (long long p = inicio_[i]; p < inicio_[i + 1]; ++p) {
+                        long long d = pos[colunasIdx_[p]]++;
+                        colunasT[d] = i;
+                        valoresT[d] = valores_[p];
+                    }
+                }
+            }
+        });
+
+        return MatrizCSR(colunas_, linhas_, std::move(inicioT), std::move(colunasT), std::move(valoresT));
+    }
+};
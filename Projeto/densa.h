@@ -1,3 +1,4 @@
+#pragma once
 #include <stdio.h>
 #include <iostream>
 #include <vector>
@@ -5,6 +6,11 @@
 #include <random>
 #include <stdexcept>
 #include <map>
+#include "paralelo.h"
+#include "uso_memoria.h"
+#include "simd.h"
+#include "csr.h"
+#include "alocacao.h"
 using namespace std;
 
 /*
@@ -16,23 +22,113 @@ using namespace std;
 class MatrizDensa{
 
 private:
-    vector<vector<double>> elementos_;
     int linhas_;
     int colunas_;
+    // linha i em [i*colunas_, (i+1)*colunas_), numa regiao so (alocacao.h)
+    RegiaoContigua<double> elementos_;
+
+    // Percorre as linhas (em paralelo) com opVetor nos blocos de LARGURA_SIMD
+    // colunas e opEscalar no resto: c[j] = op(a[j], b[j]). c pode ser a
+    // propria linha de a (operacoes em place).
+    template <typename OpVetor, typename OpEscalar>
+    void combinarLinhas(const MatrizDensa& outra, MatrizDensa& destino, OpVetor opVetor, OpEscalar opEscalar) const {
+        const int n = colunas_;
+        paraleloPara(linhas_, threadsPara((long long)linhas_ * colunas_, 1 << 16), [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                const double* a = linha(i);
+                const double* b = outra.linha(i);
+                double* c = destino.linha(i);
+                int j = 0;
+                for (; j + LARGURA_SIMD <= n; j += LARGURA_SIMD)
+                    simdGuardar(c + j, opVetor(simdCarregar(a + j), simdCarregar(b + j)));
+                for (; j < n; ++j) c[j] = opEscalar(a[j], b[j]);
+            }
+        });
+    }
+
+    // soma (ou soma dos |a[j]|) de uma linha: LARGURA_SIMD somas parciais e
+    // uma soma horizontal no fim
+    static double somarLinha(const double* a, int n, bool absoluto) {
+        VetorSimd acc = simdRepetir(0.0);
+        int j = 0;
+        for (; j + LARGURA_SIMD <= n; j += LARGURA_SIMD) {
+            VetorSimd v = simdCarregar(a + j);
+            acc = simdSomar(acc, absoluto ? simdAbsoluto(v) : v);
+        }
+        double soma = simdSomaHorizontal(acc);
+        for (; j < n; ++j) soma += absoluto ? fabs(a[j]) : a[j];
+        return soma;
+    }
+
+    static double somarQuadrados(const double* a, int n) {
+        VetorSimd acc = simdRepetir(0.0);
+        int j = 0;
+        for (; j + LARGURA_SIMD <= n; j += LARGURA_SIMD) {
+            VetorSimd v = simdCarregar(a + j);
+            acc = simdSomar(acc, simdMultiplicar(v, v));
+        }
+        double soma = simdSomaHorizontal(acc);
+        for (; j < n; ++j) soma += a[j] * a[j];
+        return soma;
+    }
+
+    // somas das colunas: cada thread acumula as suas linhas num vetor proprio
+    // (linhas somadas com SIMD) e os parciais sao juntados em ordem
+    vector<double> somarColunas(bool absoluto) const {
+        const int n = colunas_;
+        auto somarVetores = [n](vector<double> a, const vector<double>& b) {
+            int j = 0;
+            for (; j + LARGURA_SIMD <= n; j += LARGURA_SIMD)
+                simdGuardar(a.data() + j, simdSomar(simdCarregar(a.data() + j), simdCarregar(b.data() + j)));
+            for (; j < n; ++j) a[j] += b[j];
+            return a;
+        };
+        return reduzirParalelo(linhas_, threadsPara((long long)linhas_ * colunas_, 1 << 18), vector<double>(n, 0.0),
+            [&](long long ini, long long fim) {
+                vector<double> acc(n, 0.0);
+                for (long long i = ini; i < fim; ++i) {
+                    const double* a = linha(i);
+                    int j = 0;
+                    for (; j + LARGURA_SIMD <= n; j += LARGURA_SIMD) {
+                        VetorSimd v = simdCarregar(a + j);
+                        simdGuardar(acc.data() + j, simdSomar(simdCarregar(acc.data() + j), absoluto ? simdAbsoluto(v) : v));
+                    }
+                    for (; j < n; ++j) acc[j] += absoluto ? fabs(a[j]) : a[j];
+                }
+                return acc;
+            },
+            somarVetores);
+    }
 
 public:
     //construtor
-    MatrizDensa(int linhas_, int colunas_): linhas_(linhas_), colunas_(colunas_), elementos_(linhas_, vector<double> (colunas_, 0.0)){}
+    MatrizDensa(int linhas_, int colunas_): linhas_(linhas_), colunas_(colunas_),
+        elementos_((size_t)max(0, linhas_) * (size_t)max(0, colunas_), linhas_){}
+
+    //CONVERSAO DE UMA ESPARSA (HashDup, TreeDup ou CSR, na orientacao ativa)
+    // As linhas nao vazias sao divididas entre as threads e cada uma escreve
+    // direto nas suas linhas, sem set por elemento
+    template <typename Esparsa, typename = decltype(declval<const Esparsa&>().getNaoNulos())>
+    explicit MatrizDensa(const Esparsa& M) : MatrizDensa(M.getLinhas(), M.getColunas()) {
+        vector<int> naoVazias;
+        M.paraCadaLinhaNaoVazia([&](int i) { naoVazias.push_back(i); });
+        paraleloPara((long long)naoVazias.size(), threadsPara((long long)M.getNaoNulos(), 1 << 15), [&](long long r0, long long r1, int) {
+            for (long long r = r0; r < r1; ++r) {
+                double* a = linha(naoVazias[r]);
+                M.paraCadaNaLinha(naoVazias[r], [&](int j, double v) { a[j] = v; });
+            }
+        });
+    }
     
     //INSERIR OU ATUALIZAR ELEMENTO
     void set(int i, int j, double valor) {
-        elementos_[i][j] = valor;
+        linha(i)[j] = valor;
     }   
     
     //ACESSAR ELEMENTO
     double getElemento(int i, int j) const {
         if (i >= 0 && i < linhas_ && j >=0 && j < colunas_){
-            return elementos_[i][j];
+            return linha(i)[j];
         }
         return 0;
     }
@@ -45,15 +141,90 @@ public:
         return colunas_;
     }
 
+    //USO DE MEMORIA (O(linhas))
+    UsoMemoria usoMemoria() const {
+        UsoMemoria u;
+        u.objeto = sizeof(*this);
+        u.contiguo = elementos_.bytes();
+        u.valores = (size_t)linhas_ * colunas_ * sizeof(double);
+        return u;
+    }
+
+    // linha i contigua (para os kernels que misturam densa e esparsa)
+    const double* linha(int i) const {
+        return elementos_.dados() + (size_t)i * colunas_;
+    }
+    double* linha(int i) {
+        return elementos_.dados() + (size_t)i * colunas_;
+    }
+
+    //CONVERTER PARA CSR
+    // Varredura SIMD dos nao-nulos em duas passadas paralelas por faixas de
+    // linhas: conta os nao-nulos de cada linha (popcount da mascara de
+    // comparacao), soma de prefixos, e compacta cada linha na sua faixa
+    // percorrendo so os bits ligados da mascara. Os sparse de verdade saem
+    // daqui em bloco: MatrizEsparsaHashDup(D) / MatrizEsparsaTreeDup(D).
+    MatrizCSR paraCSR() const {
+        const int n = colunas_;
+        int threads = threadsPara((long long)linhas_ * colunas_, 1 << 16);
+        vector<long long> inicio((size_t)max(0, linhas_) + 1, 0);
+        paraleloPara(linhas_, threads, [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                const double* a = linha(i);
+                long long c = 0;
+                int j = 0;
+                for (; j + LARGURA_SIMD <= n; j += LARGURA_SIMD) c += __builtin_popcount(simdMascaraNaoNulos(simdCarregar(a + j)));
+                for (; j < n; ++j) c += a[j] != 0.0;
+                inicio[i + 1] = c;
+            }
+        });
+        for (int i = 0; i < linhas_; ++i) inicio[i + 1] += inicio[i];
+
+        long long nnz = inicio[max(0, linhas_)];
+        vector<int> cols((size_t)nnz);
+        vector<double> vals((size_t)nnz);
+        paraleloPara(linhas_, threads, [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                const double* a = linha(i);
+                long long d = inicio[i];
+                int j = 0;
+                for (; j + LARGURA_SIMD <= n; j += LARGURA_SIMD) {
+                    for (int m = simdMascaraNaoNulos(simdCarregar(a + j)); m; m &= m - 1) {
+                        int k = j + __builtin_ctz(m);
+                        cols[d] = k;
+                        vals[d++] = a[k];
+                    }
+                }
+                for (; j < n; ++j) {
+                    if (a[j] == 0.0) continue;
+                    cols[d] = j;
+                    vals[d++] = a[j];
+                }
+            }
+        });
+        return MatrizCSR(linhas_, colunas_, std::move(inicio), std::move(cols), std::move(vals));
+    }
+
     //RETORNAR TRANSPOSTA
+    // Em blocos de BLOCO x BLOCO para que as leituras e as escritas fiquem na
+    // cache; as faixas de blocos de linhas sao divididas entre as threads.
     MatrizDensa transposta() const {
         MatrizDensa resultado(colunas_, linhas_); 
-        
-        for (int i = 0; i < linhas_; ++i) {
-            for (int j = 0; j < colunas_; ++j) {
-                resultado.set(j, i, elementos_[i][j]); 
+        const int BLOCO = 64;
+        int faixas = (linhas_ + BLOCO - 1) / BLOCO;
+
+        paraleloPara(faixas, threadsPara((long long)linhas_ * colunas_, 1 << 18), [&](long long f0, long long f1, int) {
+            for (int ib = (int)f0 * BLOCO; ib < min(linhas_, (int)f1 * BLOCO); ib += BLOCO) {
+                int iFim = min(linhas_, ib + BLOCO);
+                for (int jb = 0; jb < colunas_; jb += BLOCO) {
+                    int jFim = min(colunas_, jb + BLOCO);
+                    for (int i = ib; i < iFim; ++i) {
+                        const double* origem = linha(i);
+                        for (int j = jb; j < jFim; ++j) resultado.linha(j)[i] = origem[j];
+                    }
+                }
             }
-        }
+        });
         return resultado;
     }
     
@@ -64,7 +235,7 @@ public:
         
         for (int i = 0; i < linhas_; ++i) {
             for (int j = 0; j < colunas_; ++j) {
-                double soma = elementos_[i][j] + outra.elementos_[i][j];
+                double soma = linha(i)[j] + outra.linha(i)[j];
                 resultado.set(i, j, soma);
             }
         }
@@ -78,7 +249,7 @@ public:
         
         for (int i = 0; i < linhas_; ++i) {
             for (int j = 0; j < colunas_; ++j) {
-                double produto = elementos_[i][j] * escalar;
+                double produto = linha(i)[j] * escalar;
                 resultado.set(i, j, produto);
             }
         }
@@ -87,28 +258,166 @@ public:
    void multiplicarEscalarInPlace(double escalar) {
         for (int i = 0; i < linhas_; ++i) {
             for (int j = 0; j < colunas_; ++j) {
-                elementos_[i][j] *= escalar;
+                linha(i)[j] *= escalar;
             }
         }
     }
 
 
+    //OPERACOES ELEMENTO A ELEMENTO (SIMD, em paralelo por faixas de linhas)
+    // Produto de Hadamard: C[i][j] = A[i][j] * B[i][j]
+    MatrizDensa produtoHadamard(const MatrizDensa& outra) const {
+        MatrizDensa resultado(linhas_, colunas_);
+        combinarLinhas(outra, resultado,
+                       [](VetorSimd a, VetorSimd b) { return simdMultiplicar(a, b); },
+                       [](double a, double b) { return a * b; });
+        return resultado;
+    }
+
+    MatrizDensa maximoElemento(const MatrizDensa& outra) const {
+        MatrizDensa resultado(linhas_, colunas_);
+        combinarLinhas(outra, resultado,
+                       [](VetorSimd a, VetorSimd b) { return simdMaximo(a, b); },
+                       [](double a, double b) { return escalarMaximo(a, b); });
+        return resultado;
+    }
+
+    MatrizDensa minimoElemento(const MatrizDensa& outra) const {
+        MatrizDensa resultado(linhas_, colunas_);
+        combinarLinhas(outra, resultado,
+                       [](VetorSimd a, VetorSimd b) { return simdMinimo(a, b); },
+                       [](double a, double b) { return escalarMinimo(a, b); });
+        return resultado;
+    }
+
+    // A o= M em place. Mascara estrutural (usarValores=false): zera onde M e
+    // zero; com usarValores=true multiplica pelos valores de M.
+    void mascarar(const MatrizDensa& M, bool usarValores = false) {
+        if (usarValores) {
+            combinarLinhas(M, *this,
+                           [](VetorSimd a, VetorSimd m) { return simdMultiplicar(a, m); },
+                           [](double a, double m) { return a * m; });
+        } else {
+            combinarLinhas(M, *this,
+                           [](VetorSimd a, VetorSimd m) { return simdOndeNaoNulo(a, m); },
+                           [](double a, double m) { return escalarOndeNaoNulo(a, m); });
+        }
+    }
+
+    // A[i][j] = f(A[i][j]) em todas as posicoes (inclusive os zeros)
+    template <typename F>
+    void aplicar(F f) {
+        paraleloPara(linhas_, threadsPara((long long)linhas_ * colunas_, 1 << 16), [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                double* a = linha(i);
+                for (int j = 0; j < colunas_; ++j) a[j] = f(a[j]);
+            }
+        });
+    }
+
+    //REDUCOES (SIMD, em paralelo por faixas de linhas)
+    vector<double> somaLinhas() const {
+        vector<double> s((size_t)max(0, linhas_), 0.0);
+        paraleloPara(linhas_, threadsPara((long long)linhas_ * colunas_, 1 << 16), [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) s[i] = somarLinha(linha(i), colunas_, false);
+        });
+        return s;
+    }
+
+    vector<double> somaColunas() const {
+        return somarColunas(false);
+    }
+
+    double normaFrobenius() const {
+        return sqrt(reduzirParalelo(linhas_, threadsPara((long long)linhas_ * colunas_, 1 << 16), 0.0,
+            [&](long long ini, long long fim) {
+                double soma = 0.0;
+                for (long long i = ini; i < fim; ++i) soma += somarQuadrados(linha(i), colunas_);
+                return soma;
+            },
+            [](double a, double b) { return a + b; }));
+    }
+
+    // norma 1 (induzida): maior soma absoluta de coluna
+    double normaL1() const {
+        vector<double> c = somarColunas(true);
+        return c.empty() ? 0.0 : *max_element(c.begin(), c.end());
+    }
+
+    // norma infinito (induzida): maior soma absoluta de linha
+    double normaInfinito() const {
+        return reduzirParalelo(linhas_, threadsPara((long long)linhas_ * colunas_, 1 << 16), 0.0,
+            [&](long long ini, long long fim) {
+                double m = 0.0;
+                for (long long i = ini; i < fim; ++i) m = max(m, somarLinha(linha(i), colunas_, true));
+                return m;
+            },
+            [](double a, double b) { return max(a, b); });
+    }
+
+    double traco() const {
+        double soma = 0.0;
+        for (int i = 0; i < min(linhas_, colunas_); ++i) soma += linha(i)[i];
+        return soma;
+    }
+
+    vector<int> nnzPorLinha() const {
+        vector<int> nnz((size_t)max(0, linhas_), 0);
+        paraleloPara(linhas_, threadsPara((long long)linhas_ * colunas_, 1 << 16), [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                const double* a = linha(i);
+                int c = 0;
+                for (int j = 0; j < colunas_; ++j) c += a[j] != 0.0;
+                nnz[i] = c;
+            }
+        });
+        return nnz;
+    }
+
+    vector<int> nnzPorColuna() const {
+        vector<int> nnz((size_t)max(0, colunas_), 0);
+        for (int i = 0; i < linhas_; ++i) {
+            const double* a = linha(i);
+            for (int j = 0; j < colunas_; ++j) nnz[j] += a[j] != 0.0;
+        }
+        return nnz;
+    }
+
+    //MULTIPLICACAO POR VETOR: y = A*x, em paralelo por faixas de linhas
+    vector<double> multiplicarVetor(const vector<double>& x) const {
+        vector<double> y((size_t)max(0, linhas_), 0.0);
+        paraleloPara(linhas_, threadsPara((long long)linhas_ * colunas_, 1 << 16), [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                const double* a = linha(i);
+                double soma = 0.0;
+                for (int j = 0; j < colunas_; ++j) soma += a[j] * x[j];
+                y[i] = soma;
+            }
+        });
+        return y;
+    }
+
     //MULTIPLICACAO DE MATRIZES
+    // Ordem i-k-j: a linha k de B e a linha i de C sao percorridas em
+    // sequencia (no i-j-k a coluna de B pula uma linha inteira a cada passo).
+    // Cada C[i][j] continua somando os k em ordem crescente, entao o resultado
+    // e o mesmo de antes. As faixas de linhas de C sao divididas entre as threads.
     MatrizDensa multiplicar(const MatrizDensa& outra) const {
-        //como so tratamos com matrizes quadradas nos casos testes nao vai dar problema
-        const int dimensao = linhas_; 
-        MatrizDensa resultado(dimensao, dimensao); 
-
-        for (int i = 0; i < dimensao; ++i) { 
-            for (int j = 0; j < dimensao; ++j) { 
-                double soma_produto = 0.0;
-                for (int k = 0; k < dimensao; ++k) { 
+        const int n = linhas_, m = colunas_, p = outra.colunas_;
+        MatrizDensa resultado(n, p);
+
+        paraleloPara(n, threadsPara((long long)n * m * p, 1 << 20), [&](long long i0, long long i1, int) {
+            for (long long i = i0; i < i1; ++i) {
+                double* c = resultado.linha(i);
+                const double* a = linha(i);
+                for (int k = 0; k < m; ++k) {
                     // C[i][j] += A[i][k] * B[k][j]
-                    soma_produto += elementos_[i][k] * outra.elementos_[k][j];
+                    const double aik = a[k];
+                    const double* b = outra.linha(k);
+                    for (int j = 0; j < p; ++j) c[j] += aik * b[j];
                 }
-                resultado.set(i, j, soma_produto);
             }
-        }
+        });
         return resultado;
     }
 };
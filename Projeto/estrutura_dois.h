@@ -1,9 +1,16 @@
+#pragma once
 #include <stdio.h>
 #include <iostream>
 #include <vector>
 #include <bits/stdc++.h>
 #include <algorithm> 
 #include <map>
+#include "pool.h"
+#include "produto_esparso.h"
+#include "csr.h"
+#include "paralelo.h"
+#include "uso_memoria.h"
+#include "poda.h"
 using namespace std;
 
 /*
@@ -22,54 +29,303 @@ class MatrizEsparsaTreeDup {
 private:
     int linhas_, colunas_;
 
+    PoolNos<Node2> nos_;
+    uint64_t versaoPadrao_;
+
     map<int, map<int, Node2*>> mapPorLinha;
     map<int, map<int, Node2*>> mapPorColuna;
 
     map<int, map<int, Node2*>>* linhaPtr;
     map<int, map<int, Node2*>>* colPtr;
     
+    // Copia profunda: os blocos de nos sao copiados com memcpy e as arvores
+    // sao copiadas estruturalmente (sem rebalancear), so trocando os ponteiros
+    // dos valores para os nos equivalentes da copia.
     MatrizEsparsaTreeDup(const MatrizEsparsaTreeDup& original)
-        : linhas_(original.linhas_), colunas_(original.colunas_)
+        : linhas_(original.linhas_), colunas_(original.colunas_),
+          versaoPadrao_(original.versaoPadrao_),
+          mapPorLinha(original.mapPorLinha), mapPorColuna(original.mapPorColuna)
     {
         linhaPtr = &mapPorLinha;
         colPtr = &mapPorColuna;
-        
-        for (auto const& [i, innerMap] : original.mapPorLinha) {
-            for (auto const& [j, nodeOriginal] : innerMap) {
-                Node2* novo = new Node2(i, j, nodeOriginal->valor);
-                
-                mapPorLinha[i][j] = novo;
-                mapPorColuna[j][i] = novo;
-            }
-        }
+
+        nos_.copiarBlocosDe(original.nos_);
+        for (auto& [i, inner] : mapPorLinha)
+            for (auto& [j, node] : inner) node = nos_.traduzir(original.nos_, node);
+        for (auto& [j, inner] : mapPorColuna)
+            for (auto& [i, node] : inner) node = nos_.traduzir(original.nos_, node);
         
         if (original.linhaPtr == &original.mapPorColuna) {
             swap(linhaPtr, colPtr);
         }
     }
 
+    // Toma posse da estrutura de `o` e deixa `o` como uma matriz 0x0 valida
+    void moverDe(MatrizEsparsaTreeDup& o) {
+        bool transposta = (o.linhaPtr == &o.mapPorColuna);
+        linhas_ = o.linhas_;
+        colunas_ = o.colunas_;
+        nos_ = std::move(o.nos_);
+        versaoPadrao_ = o.versaoPadrao_;
+        mapPorLinha = std::move(o.mapPorLinha);
+        mapPorColuna = std::move(o.mapPorColuna);
+        linhaPtr = &mapPorLinha;
+        colPtr = &mapPorColuna;
+        if (transposta) swap(linhaPtr, colPtr);
+
+        o.linhas_ = o.colunas_ = 0;
+        o.versaoPadrao_ = novaVersaoPadrao();
+        o.mapPorLinha.clear();
+        o.mapPorColuna.clear();
+        o.linhaPtr = &o.mapPorLinha;
+        o.colPtr = &o.mapPorColuna;
+    }
+
+    // Fase simbolica de this*B (ver produto_esparso.h)
+    void calcularPadrao(const MatrizEsparsaTreeDup& B, PadraoProduto& P) const {
+        P.iniciar(linhas_, B.colunas_);
+        AcumuladorLinha acc(B.colunas_, (long long)(nos_.tamanho() + B.nos_.tamanho()));
+        for (auto const& [i, linhaA] : *linhaPtr) {
+            for (auto const& [k, na] : linhaA) {
+                auto rowBkIt = B.linhaPtr->find(k);
+                if (rowBkIt == B.linhaPtr->end()) continue;
+                for (auto const& [j, nb] : rowBkIt->second) acc.marcar(j);
+            }
+            P.fecharLinha(i, acc);
+        }
+        P.marcarCalculado(versaoPadrao_, estaTransposta(), B.versaoPadrao_, B.estaTransposta());
+    }
+
+    // Fase numerica: as colunas de cada linha ja vem ordenadas, entao todas as
+    // insercoes em C sao no fim das arvores (emplace_hint em O(1) amortizado)
+    MatrizEsparsaTreeDup multiplicarNumerico(const MatrizEsparsaTreeDup& B, const PadraoProduto& P, const Poda& poda) const {
+        MatrizEsparsaTreeDup C(this->linhas_, B.colunas_);
+        C.nos_.reservar((size_t)P.nnz());
+
+        AcumuladorLinha acc(B.colunas_, (long long)(nos_.tamanho() + B.nos_.tamanho()));
+        vector<pair<int, double>> linha;
+        for (size_t r = 0; r < P.linhasPadrao.size(); ++r) {
+            int i = P.linhasPadrao[r];
+            auto itA = linhaPtr->find(i);
+            for (auto const& [k, na] : itA->second) {
+                auto rowBkIt = B.linhaPtr->find(k);
+                if (rowBkIt == B.linhaPtr->end()) continue;
+                for (auto const& [j, nb] : rowBkIt->second) acc.somar(j, na->valor * nb->valor);
+            }
+
+            map<int, Node2*>& linhaC = C.mapPorLinha.emplace_hint(C.mapPorLinha.end(), i, map<int, Node2*>())->second;
+            auto inserir = [&](int j, double v) {
+                Node2* novo = C.nos_.alocar(i, j, v);
+                linhaC.emplace_hint(linhaC.end(), j, novo);
+                map<int, Node2*>& colunaC = C.mapPorColuna[j];
+                colunaC.emplace_hint(colunaC.end(), i, novo);
+            };
+            linha.clear();
+            for (long long p = P.inicio[r]; p < P.inicio[r + 1]; ++p) {
+                int j = P.colunasPadrao[p];
+                double v = acc.retirar(j);
+                if (!poda.manter(v)) continue;
+                if (poda.limitaLinha()) linha.push_back(make_pair(j, v));
+                else inserir(j, v);
+            }
+            poda.limitar(linha);
+            for (auto const& e : linha) inserir(e.first, e.second);
+            if (linhaC.empty()) C.mapPorLinha.erase(i);
+            acc.limparValores();
+        }
+        return C;
+    }
+
+    // Arvores internas de um mapa externo (linhas ou colunas nao vazias),
+    // para dividir entre as threads
+    static vector<pair<int, const map<int, Node2*>*>> listarArvores(const map<int, map<int, Node2*>>& externo) {
+        vector<pair<int, const map<int, Node2*>*>> lista;
+        lista.reserve(externo.size());
+        for (auto const& [k, inner] : externo) lista.push_back(make_pair(k, &inner));
+        return lista;
+    }
+
+    vector<pair<int, const map<int, Node2*>*>> listarLinhas() const {
+        return listarArvores(*linhaPtr);
+    }
+
+    // Soma (ou soma dos |valor|) de cada arvore interna, em paralelo
+    vector<double> somarArvores(const map<int, map<int, Node2*>>& externo, int n, bool absoluto) const {
+        vector<double> s((size_t)max(0, n), 0.0);
+        auto lista = listarArvores(externo);
+        paraleloPara((long long)lista.size(), threadsPara((long long)nos_.tamanho(), 1 << 15), [&](long long ini, long long fim, int) {
+            for (long long r = ini; r < fim; ++r) {
+                double soma = 0.0;
+                for (auto const& [k, no] : *lista[r].second) soma += absoluto ? fabs(no->valor) : no->valor;
+                s[lista[r].first] = soma;
+            }
+        });
+        return s;
+    }
+
+    // Remove os nos juntados pelas threads (coordenadas fisicas, como o set)
+    void removerNos(const vector<vector<Node2*>>& remover) {
+        for (auto const& lista : remover)
+            for (Node2* n : lista) set(n->i, n->j, 0.0);
+    }
 
 public:
     //construtor 
     MatrizEsparsaTreeDup(int linhas, int colunas)
         : linhas_(linhas), colunas_(colunas)
     {
+        versaoPadrao_ = novaVersaoPadrao();
         linhaPtr = &mapPorLinha;
         colPtr = &mapPorColuna;
     }
 
-    int getLinhas() const { return linhas_; }
-    int getColunas() const { return colunas_; }
+    // Construcao em bloco a partir de uma CSR: as linhas chegam ordenadas,
+    // entao todas as insercoes nas arvores sao no fim (emplace_hint O(1)).
+    // Os nos criados (em ordem de linha) sao postos em ordem de coluna por
+    // contagem sobre as colunas -- estavel, entao as linhas de cada coluna
+    // continuam crescentes -- e as arvores de coluna tambem so recebem
+    // insercoes no fim. Com muito mais colunas que nao-nulos (hiperesparsa)
+    // o histograma O(colunas) nao compensa e a ordenacao e por comparacao.
+    explicit MatrizEsparsaTreeDup(const MatrizCSR& M)
+        : MatrizEsparsaTreeDup(M.getLinhas(), M.getColunas())
+    {
+        const vector<long long>& inicio = M.inicio();
+        const vector<int>& cols = M.colunasIdx();
+        const vector<double>& vals = M.valores();
+        nos_.reservar(M.getNaoNulos());
 
-    // DESTRUTOR 
-    ~MatrizEsparsaTreeDup() {
-        for (auto itOuter = mapPorLinha.begin(); itOuter != mapPorLinha.end(); ++itOuter) {
-            for (auto itInner = itOuter->second.begin(); itInner != itOuter->second.end(); ++itInner) {
-                if (itInner->second) delete itInner->second;
+        vector<Node2*> porLinha;
+        porLinha.reserve(M.getNaoNulos());
+        M.paraCadaLinhaNaoVazia([&](int i) {
+            map<int, Node2*>& linha = mapPorLinha.emplace_hint(mapPorLinha.end(), i, map<int, Node2*>())->second;
+            for (long long p = inicio[i]; p < inicio[i + 1]; ++p) {
+                if (vals[p] == 0.0) continue;
+                Node2* novo = nos_.alocar(i, cols[p], vals[p]);
+                linha.emplace_hint(linha.end(), cols[p], novo);
+                porLinha.push_back(novo);
             }
+            if (linha.empty()) mapPorLinha.erase(i);
+        });
+
+        size_t nnz = porLinha.size();
+        vector<Node2*> porColuna(nnz);
+        if ((long long)colunas_ <= 8 * (long long)nnz) {
+            vector<size_t> pos((size_t)max(0, colunas_) + 1, 0);
+            for (Node2* n : porLinha) ++pos[n->j + 1];
+            for (int j = 0; j < colunas_; ++j) pos[j + 1] += pos[j];
+            for (Node2* n : porLinha) porColuna[pos[n->j]++] = n;
+        } else {
+            porColuna = porLinha;
+            stable_sort(porColuna.begin(), porColuna.end(), [](Node2* a, Node2* b) { return a->j < b->j; });
+        }
+
+        map<int, Node2*>* coluna = nullptr;
+        for (size_t r = 0; r < nnz; ++r) {
+            Node2* n = porColuna[r];
+            if (r == 0 || porColuna[r - 1]->j != n->j)
+                coluna = &mapPorColuna.emplace_hint(mapPorColuna.end(), n->j, map<int, Node2*>())->second;
+            coluna->emplace_hint(coluna->end(), n->i, n);
         }
     }
 
+    // Qualquer outro formato com paraCSR() (MatrizDensa, HashDup): converte
+    // em bloco e constroi como acima
+    template <typename Matriz, typename = decltype(declval<const Matriz&>().paraCSR())>
+    explicit MatrizEsparsaTreeDup(const Matriz& M)
+        : MatrizEsparsaTreeDup(M.paraCSR()) {}
+
+    int getLinhas() const { return linhas_; }
+    int getColunas() const { return colunas_; }
+    size_t getNaoNulos() const { return nos_.tamanho(); }
+
+    // muda sempre que um nao-nulo e inserido ou removido (nao muda com valores)
+    uint64_t versaoPadrao() const { return versaoPadrao_; }
+    bool estaTransposta() const { return linhaPtr == &mapPorColuna; }
+
+    // DESTRUTOR (os nos sao liberados junto com os blocos do pool)
+    ~MatrizEsparsaTreeDup() {}
+
+    MatrizEsparsaTreeDup& operator=(const MatrizEsparsaTreeDup&) = delete;
+
+    //MOVER: O(1)
+    MatrizEsparsaTreeDup(MatrizEsparsaTreeDup&& o) noexcept {
+        moverDe(o);
+    }
+    MatrizEsparsaTreeDup& operator=(MatrizEsparsaTreeDup&& o) noexcept {
+        if (this != &o) moverDe(o);
+        return *this;
+    }
+
+    //CLONAR (copia profunda explicita)
+    MatrizEsparsaTreeDup clonar() const {
+        return MatrizEsparsaTreeDup(*this);
+    }
+
+    // nao-nulos da linha i / coluna j na orientacao ativa (tamanho da arvore interna)
+    int nnzNaLinha(int i) const {
+        auto it = linhaPtr->find(i);
+        return it == linhaPtr->end() ? 0 : (int)it->second.size();
+    }
+    int nnzNaColuna(int j) const {
+        auto it = colPtr->find(j);
+        return it == colPtr->end() ? 0 : (int)it->second.size();
+    }
+
+    //USO DE MEMORIA (O(blocos do pool), nao percorre os elementos)
+    // Cada nao-nulo tem um no em cada arvore interna (por linha e por coluna);
+    // as arvores externas tem um no por linha/coluna nao vazia
+    UsoMemoria usoMemoria() const {
+        UsoMemoria u;
+        u.objeto = sizeof(*this);
+        u.nos = nos_.bytesReservados();
+        u.nosVivos = nos_.tamanho();
+        u.nosLivres = nos_.livres();
+        u.arvores = bytesArvoreDupla(mapPorLinha, nos_.tamanho()) + bytesArvoreDupla(mapPorColuna, nos_.tamanho());
+        u.valores = nos_.tamanho() * sizeof(double);
+        return u;
+    }
+
+    // contagens por linha/coluna para o planejador de cadeias (cadeia.h)
+    EstatisticasPadrao estatisticas() const {
+        EstatisticasPadrao E;
+        E.linhas = linhas_;
+        E.colunas = colunas_;
+        for (auto const& [i, inner] : *linhaPtr) E.porLinha.push_back(make_pair(i, (double)inner.size()));
+        for (auto const& [j, inner] : *colPtr) E.porColuna.push_back(make_pair(j, (double)inner.size()));
+        E.nnz = (double)nos_.tamanho();
+        return E;
+    }
+
+    //PERCORRER ELEMENTOS (sempre na orientacao ativa)
+    // f(j, valor) para cada nao-nulo da linha i, com j crescente
+    template <typename F>
+    void paraCadaNaLinha(int i, F f) const {
+        auto it = linhaPtr->find(i);
+        if (it == linhaPtr->end()) return;
+        for (auto const& [j, n] : it->second) f(j, n->valor);
+    }
+
+    // f(i, valor) para cada nao-nulo da coluna j, com i crescente
+    template <typename F>
+    void paraCadaNaColuna(int j, F f) const {
+        auto it = colPtr->find(j);
+        if (it == colPtr->end()) return;
+        for (auto const& [i, n] : it->second) f(i, n->valor);
+    }
+
+    // f(i) para cada linha com pelo menos um nao-nulo, em ordem crescente
+    template <typename F>
+    void paraCadaLinhaNaoVazia(F f) const {
+        for (auto const& linha : *linhaPtr) f(linha.first);
+    }
+
+    // f(i, j, valor) para todos os nao-nulos, em ordem de linha e coluna
+    template <typename F>
+    void paraCadaElemento(F f) const {
+        for (auto const& [i, inner] : *linhaPtr)
+            for (auto const& [j, n] : inner) f(i, j, n->valor);
+    }
+
     //INSERIR OU ATUALIZAR ELEMENTO
     void set(int i, int j, double valor) {
         if (i < 0 || j < 0) return;
@@ -86,7 +342,8 @@ public:
                     mapPorColuna[j].erase(i);
                     if (mapPorColuna[j].empty()) mapPorColuna.erase(j);
 
-                    delete n;
+                    nos_.liberar(n);
+                    versaoPadrao_ = novaVersaoPadrao();
                 } else {
                     n->valor = valor;
                 }
@@ -95,9 +352,10 @@ public:
         }
         if (valor == 0.0) return;
 
-        Node2* novo = new Node2(i, j, valor);
+        Node2* novo = nos_.alocar(i, j, valor);
         mapPorLinha[i][j] = novo; 
         mapPorColuna[j][i] = novo; 
+        versaoPadrao_ = novaVersaoPadrao();
     }
 
     //ACESSAR ELEMENTO
@@ -116,6 +374,40 @@ public:
         swap(linhas_, colunas_);
     }
 
+    //CONVERTER PARA CSR (orientacao ativa)
+    MatrizCSR paraCSR() const {
+        vector<pair<int, const map<int, Node2*>*>> linhas;
+        linhas.reserve(linhaPtr->size());
+        for (auto const& [i, inner] : *linhaPtr)
+            if (i < linhas_) linhas.push_back(make_pair(i, &inner));
+
+        vector<long long> inicio((size_t)max(0, linhas_) + 1, 0);
+        for (auto const& l : linhas) inicio[l.first + 1] = (long long)l.second->size();
+        for (int i = 0; i < linhas_; ++i) inicio[i + 1] += inicio[i];
+        long long nnz = inicio[max(0, linhas_)];
+
+        vector<int> cols((size_t)nnz);
+        vector<double> vals((size_t)nnz);
+        paraleloPara((long long)linhas.size(), threadsPara(nnz, 1 << 15), [&](long long ini, long long fim, int) {
+            for (long long r = ini; r < fim; ++r) {
+                long long p = inicio[linhas[r].first];
+                for (auto const& [j, n] : *linhas[r].second) {
+                    cols[p] = j;
+                    vals[p++] = n->valor;
+                }
+            }
+        });
+        return MatrizCSR(linhas_, colunas_, std::move(inicio), std::move(cols), std::move(vals));
+    }
+
+    //TRANSPOSTA EXPLICITA
+    // Monta uma matriz nova ja na outra orientacao (ordenacao por contagem em
+    // paralelo, ver MatrizCSR::transposta), em vez de so trocar os ponteiros
+    // como o transpor().
+    MatrizEsparsaTreeDup transpostaExplicita() const {
+        return MatrizEsparsaTreeDup(paraCSR().transposta());
+    }
+
     //SOMA DE MATRIZES
     MatrizEsparsaTreeDup somar(const MatrizEsparsaTreeDup& B) const {
         MatrizEsparsaTreeDup C(linhas_, colunas_);
@@ -141,6 +433,78 @@ public:
         return C;
     }
 
+    // Soma com poda: as linhas das duas (arvores ja ordenadas) sao
+    // intercaladas ja descartando o que a `poda` tira, e C e montada com
+    // insercoes no fim das arvores, como no produto. Sem CSR: nada O(linhas).
+    MatrizEsparsaTreeDup somar(const MatrizEsparsaTreeDup& B, const Poda& poda) const {
+        static const map<int, Node2*> vazia;
+        MatrizEsparsaTreeDup C(linhas_, colunas_);
+        vector<pair<int, double>> linha;
+        auto itA = linhaPtr->begin(), itB = B.linhaPtr->begin();
+        while (itA != linhaPtr->end() || itB != B.linhaPtr->end()) {
+            bool temA = itA != linhaPtr->end(), temB = itB != B.linhaPtr->end();
+            int i = !temB || (temA && itA->first < itB->first) ? itA->first : itB->first;
+            const map<int, Node2*>& a = temA && itA->first == i ? (itA++)->second : vazia;
+            const map<int, Node2*>& b = temB && itB->first == i ? (itB++)->second : vazia;
+
+            linha.clear();
+            auto emitir = [&](int j, double v) { if (v != 0.0 && poda.manter(v)) linha.push_back(make_pair(j, v)); };
+            auto p = a.begin(), q = b.begin();
+            while (p != a.end() && q != b.end()) {
+                if (p->first == q->first) { emitir(p->first, p->second->valor + q->second->valor); ++p; ++q; }
+                else if (p->first < q->first) { emitir(p->first, p->second->valor); ++p; }
+                else { emitir(q->first, q->second->valor); ++q; }
+            }
+            for (; p != a.end(); ++p) emitir(p->first, p->second->valor);
+            for (; q != b.end(); ++q) emitir(q->first, q->second->valor);
+            poda.limitar(linha);
+            if (linha.empty()) continue;
+
+            map<int, Node2*>& linhaC = C.mapPorLinha.emplace_hint(C.mapPorLinha.end(), i, map<int, Node2*>())->second;
+            for (auto const& [j, v] : linha) {
+                Node2* novo = C.nos_.alocar(i, j, v);
+                linhaC.emplace_hint(linhaC.end(), j, novo);
+                map<int, Node2*>& colunaC = C.mapPorColuna[j];
+                colunaC.emplace_hint(colunaC.end(), i, novo);
+            }
+        }
+        return C;
+    }
+
+    //PODA
+    // Uma passada paralela pelas linhas nao vazias acha o que sai e os nos sao
+    // tirados das arvores no lugar (sem remontar pela CSR, que custaria
+    // O(linhas), e mantendo a orientacao). Devolve quantos nao-nulos sairam.
+    size_t podar(const Poda& poda) {
+        auto linhas = listarLinhas();
+        int threads = threadsPara((long long)nos_.tamanho(), 1 << 15);
+        vector<vector<Node2*>> fora(threads);
+        paraleloPara((long long)linhas.size(), threads, [&](long long ini, long long fim, int t) {
+            vector<pair<int, double>> ficam;
+            for (long long r = ini; r < fim; ++r) {
+                ficam.clear();
+                for (auto const& [j, n] : *linhas[r].second) {
+                    if (!poda.manter(n->valor)) fora[t].push_back(n);
+                    else if (poda.limitaLinha()) ficam.push_back(make_pair(j, n->valor));
+                }
+                if ((int)ficam.size() <= poda.maioresPorLinha) continue;
+                // limite por linha: sai o que nao esta entre os k maiores
+                poda.limitar(ficam);
+                size_t f = 0;
+                for (auto const& [j, n] : *linhas[r].second) {
+                    if (!poda.manter(n->valor)) continue;
+                    if (f < ficam.size() && ficam[f].first == j) ++f;
+                    else fora[t].push_back(n);
+                }
+            }
+        });
+        size_t total = 0;
+        for (auto const& l : fora) total += l.size();
+        removerNos(fora);
+        return total;
+    }
+    size_t podar(double tolerancia) { return podar(Poda(tolerancia)); }
+
     //MULTIPLICACAO POR ESCALAR
     /*
     MatrizEsparsaTreeDup multiplicarEscalar(double escalar) const {
@@ -162,27 +526,166 @@ public:
         }
     }
 
-    // MULTIPLICACAO DE MATRIZES
-    MatrizEsparsaTreeDup multiplicar(const MatrizEsparsaTreeDup& B) const {
-        MatrizEsparsaTreeDup C(this->linhas_, B.colunas_);
+    //OPERACOES ELEMENTO A ELEMENTO
+    // Binarias: as linhas (ja ordenadas nas arvores) vao para CSR, sao
+    // intercaladas (MatrizCSR::combinar) e o resultado e montado em bloco
+    MatrizEsparsaTreeDup produtoHadamard(const MatrizEsparsaTreeDup& B) const {
+        return MatrizEsparsaTreeDup(paraCSR().produtoHadamard(B.paraCSR()));
+    }
 
-        for (auto itOuterA = this->linhaPtr->begin(); itOuterA != this->linhaPtr->end(); ++itOuterA) {
-            int i = itOuterA->first;
-            for (auto itInnerA = itOuterA->second.begin(); itInnerA != itOuterA->second.end(); ++itInnerA) {
-                int k = itInnerA->first;
-                double a_val = itInnerA->second->valor;
+    // posicao ausente de um dos lados vale 0
+    MatrizEsparsaTreeDup maximoElemento(const MatrizEsparsaTreeDup& B) const {
+        return MatrizEsparsaTreeDup(paraCSR().maximoElemento(B.paraCSR()));
+    }
+    MatrizEsparsaTreeDup minimoElemento(const MatrizEsparsaTreeDup& B) const {
+        return MatrizEsparsaTreeDup(paraCSR().minimoElemento(B.paraCSR()));
+    }
 
-                auto rowBkIt = B.linhaPtr->find(k);
-                if (rowBkIt == B.linhaPtr->end()) continue;
+    // valor = f(valor) nos nao-nulos, em paralelo pelas linhas nao vazias (os
+    // zeros nao sao visitados: f(0) deve ser 0). Os que viram zero saem.
+    template <typename F>
+    void aplicar(F f) {
+        auto linhas = listarLinhas();
+        int threads = threadsPara((long long)nos_.tamanho(), 1 << 15);
+        vector<vector<Node2*>> zerados(threads);
+        paraleloPara((long long)linhas.size(), threads, [&](long long ini, long long fim, int t) {
+            for (long long r = ini; r < fim; ++r) {
+                for (auto const& [j, n] : *linhas[r].second) {
+                    n->valor = f(n->valor);
+                    if (n->valor == 0.0) zerados[t].push_back(n);
+                }
+            }
+        });
+        removerNos(zerados);
+    }
 
-                for (auto itInnerB = rowBkIt->second.begin(); itInnerB != rowBkIt->second.end(); ++itInnerB) {
-                    int j = itInnerB->first;
-                    double b_val = itInnerB->second->valor;
-                    double atual = C.getElemento(i, j);
-                    C.set(i, j, atual + a_val * b_val);
+    // A o= M em place: sai o que nao esta no padrao de M (busca binaria na
+    // linha da CSR); com usarValores=true o que fica e multiplicado por M
+    void mascarar(const MatrizCSR& M, bool usarValores = false) {
+        auto linhas = listarLinhas();
+        int threads = threadsPara((long long)nos_.tamanho(), 1 << 15);
+        vector<vector<Node2*>> fora(threads);
+        paraleloPara((long long)linhas.size(), threads, [&](long long ini, long long fim, int t) {
+            for (long long r = ini; r < fim; ++r) {
+                int i = linhas[r].first;
+                for (auto const& [j, n] : *linhas[r].second) {
+                    double m = M.getElemento(i, j);
+                    if (usarValores) n->valor *= m;
+                    if (m == 0.0 || n->valor == 0.0) fora[t].push_back(n);
                 }
             }
+        });
+        removerNos(fora);
+    }
+
+    // M de outro formato esparso (HashDup ou TreeDup): convertida uma vez
+    template <typename Mascara>
+    void mascarar(const Mascara& M, bool usarValores = false) {
+        mascarar(M.paraCSR(), usarValores);
+    }
+
+    //REDUCOES (orientacao ativa, em paralelo pelas linhas/colunas nao vazias)
+    // As somas de coluna usam as arvores de coluna da orientacao ativa:
+    // custam o mesmo que as de linha, inclusive depois do transpor()
+    vector<double> somaLinhas() const {
+        return somarArvores(*linhaPtr, linhas_, false);
+    }
+    vector<double> somaColunas() const {
+        return somarArvores(*colPtr, colunas_, false);
+    }
+
+    double normaFrobenius() const {
+        auto linhas = listarLinhas();
+        return sqrt(reduzirParalelo((long long)linhas.size(), threadsPara((long long)nos_.tamanho(), 1 << 15), 0.0,
+            [&](long long ini, long long fim) {
+                double soma = 0.0;
+                for (long long r = ini; r < fim; ++r)
+                    for (auto const& [j, n] : *linhas[r].second) soma += n->valor * n->valor;
+                return soma;
+            },
+            [](double a, double b) { return a + b; }));
+    }
+
+    // norma 1 (induzida): maior soma absoluta de coluna
+    double normaL1() const {
+        vector<double> c = somarArvores(*colPtr, colunas_, true);
+        return c.empty() ? 0.0 : *max_element(c.begin(), c.end());
+    }
+
+    // norma infinito (induzida): maior soma absoluta de linha
+    double normaInfinito() const {
+        vector<double> l = somarArvores(*linhaPtr, linhas_, true);
+        return l.empty() ? 0.0 : *max_element(l.begin(), l.end());
+    }
+
+    double traco() const {
+        double soma = 0.0;
+        for (auto const& [i, inner] : *linhaPtr) {
+            auto it = inner.find(i);
+            if (it != inner.end()) soma += it->second->valor;
         }
+        return soma;
+    }
+
+    vector<int> nnzPorLinha() const {
+        vector<int> nnz((size_t)max(0, linhas_), 0);
+        for (auto const& [i, inner] : *linhaPtr) nnz[i] = (int)inner.size();
+        return nnz;
+    }
+    vector<int> nnzPorColuna() const {
+        vector<int> nnz((size_t)max(0, colunas_), 0);
+        for (auto const& [j, inner] : *colPtr) nnz[j] = (int)inner.size();
+        return nnz;
+    }
+
+    //MULTIPLICACAO POR VETOR (SpMV): y = A*x, x com getColunas() posicoes
+    // As linhas nao vazias sao listadas antes (como no paraCSR) e divididas
+    // entre as threads
+    vector<double> multiplicarVetor(const vector<double>& x) const {
+        vector<double> y((size_t)max(0, linhas_), 0.0);
+        auto linhas = listarLinhas();
+
+        paraleloPara((long long)linhas.size(), threadsPara((long long)nos_.tamanho(), 1 << 15), [&](long long ini, long long fim, int) {
+            for (long long r = ini; r < fim; ++r) {
+                double soma = 0.0;
+                for (auto const& [j, n] : *linhas[r].second) soma += n->valor * x[j];
+                y[linhas[r].first] = soma;
+            }
+        });
+        return y;
+    }
+
+    // MULTIPLICACAO DE MATRIZES
+    // Fase simbolica separada: o padrao pode ser guardado e reaproveitado
+    // enquanto A e B so mudarem de valores (ver produto_esparso.h)
+    PadraoProduto padraoProduto(const MatrizEsparsaTreeDup& B) const {
+        PadraoProduto P;
+        calcularPadrao(B, P);
+        return P;
+    }
+
+    // `poda` descarta os valores pequenos (e/ou limita cada linha) ja na fase
+    // numerica: o que sai nunca chega a ser inserido em C
+    MatrizEsparsaTreeDup multiplicar(const MatrizEsparsaTreeDup& B, const Poda& poda = Poda()) const {
+        PadraoProduto P;
+        calcularPadrao(B, P);
+        return multiplicarNumerico(B, P, poda);
+    }
+
+    // Recalcula `cache` so se o padrao de A ou de B mudou desde a ultima vez
+    MatrizEsparsaTreeDup multiplicar(const MatrizEsparsaTreeDup& B, PadraoProduto& cache, const Poda& poda = Poda()) const {
+        if (!cache.valido(versaoPadrao_, estaTransposta(), B.versaoPadrao_, B.estaTransposta()))
+            calcularPadrao(B, cache);
+        return multiplicarNumerico(B, cache, poda);
+    }
+
+    //MULTIPLICACAO MASCARADA: C = (A*B) o M, so nas posicoes de M
+    // M pode ser qualquer matriz esparsa (HashDup ou TreeDup)
+    template <typename Mascara>
+    MatrizEsparsaTreeDup multiplicarMascarado(const MatrizEsparsaTreeDup& B, const Mascara& M,
+                                              bool usarValores = false) const {
+        MatrizEsparsaTreeDup C(linhas_, B.colunas_);
+        produtoMascarado(*this, B, M, C, usarValores);
         return C;
     }
 };
\ No newline at end of file
@@ -1,9 +1,17 @@
+#pragma once
 #include <stdio.h>
 #include <iostream>
 #include <vector>
 #include <bits/stdc++.h>
 #include <unordered_map>
 #include <algorithm> 
+#include "pool.h"
+#include "produto_esparso.h"
+#include "csr.h"
+#include "paralelo.h"
+#include "uso_memoria.h"
+#include "indice_compacto.h"
+#include "poda.h"
 using namespace std;
 
 /*
@@ -36,18 +44,32 @@ class MatrizEsparsaHashDup {
 private:
     int linhas_, colunas_;
 
+    PoolNos<Node1> nos_;
+    uint64_t versaoPadrao_;
+
     unordered_map<uint64_t, Node1*> tabelaIJ;
     unordered_map<uint64_t, Node1*> tabelaJI;
 
-    vector<Node1*> headsRowIJ;   
-    vector<Node1*> headsColIJ;   
+    // Cabecas das listas: vetores O(dimensao) ou, no modo hiperesparso, so
+    // as linhas/colunas nao vazias (indice_compacto.h)
+    typedef IndiceCompacto<Node1*> Cabecas;
+    Cabecas headsRowIJ;   
+    Cabecas headsColIJ;   
+
+    Cabecas headsRowJI;  
+    Cabecas headsColJI;   
 
-    vector<Node1*> headsRowJI;  
-    vector<Node1*> headsColJI;   
+    // nao-nulos por linha/coluna fisica (i,j), mantidos pelo set
+    IndiceCompacto<int> nnzLinhaFisica_;
+    IndiceCompacto<int> nnzColunaFisica_;
+    // false depois de definirHiperesparso: o modo escolhido a mao nao muda sozinho
+    bool hiperAutomatico_ = true;
+    // indices das colunas fisicas com modo proprio (ver colunasCompensam)
+    bool colunasProprias_ = false;
 
     unordered_map<uint64_t, Node1*>* tabelaAtiva;
-    vector<Node1*>* headsRowAtiva;
-    vector<Node1*>* headsColAtiva;
+    Cabecas* headsRowAtiva;
+    Cabecas* headsColAtiva;
 
     unordered_map<uint64_t, Node1*>* tabelaFisicaIJ;
     unordered_map<uint64_t, Node1*>* tabelaFisicaJI;
@@ -61,15 +83,264 @@ private:
 
     bool activeIsIJ() const { return tabelaAtiva == tabelaFisicaIJ; }
 
+    void apontarAtivaPara(bool viewIsIJ) {
+        tabelaFisicaIJ = &tabelaIJ;
+        tabelaFisicaJI = &tabelaJI;
+        if (viewIsIJ) setActiveToIJ();
+        else setActiveToJI();
+    }
+
+    // Toma posse da estrutura de `o` e deixa `o` como uma matriz 0x0 valida
+    void moverDe(MatrizEsparsaHashDup& o) {
+        bool viewIsIJ = o.activeIsIJ();
+        linhas_ = o.linhas_;
+        colunas_ = o.colunas_;
+        nos_ = std::move(o.nos_);
+        versaoPadrao_ = o.versaoPadrao_;
+        tabelaIJ = std::move(o.tabelaIJ);
+        tabelaJI = std::move(o.tabelaJI);
+        headsRowIJ = std::move(o.headsRowIJ);
+        headsColIJ = std::move(o.headsColIJ);
+        headsRowJI = std::move(o.headsRowJI);
+        headsColJI = std::move(o.headsColJI);
+        nnzLinhaFisica_ = std::move(o.nnzLinhaFisica_);
+        nnzColunaFisica_ = std::move(o.nnzColunaFisica_);
+        hiperAutomatico_ = o.hiperAutomatico_;
+        colunasProprias_ = o.colunasProprias_;
+        apontarAtivaPara(viewIsIJ);
+
+        o.linhas_ = o.colunas_ = 0;
+        o.versaoPadrao_ = novaVersaoPadrao();
+        o.tabelaIJ.clear();
+        o.tabelaJI.clear();
+        o.headsRowIJ = Cabecas();
+        o.headsColIJ = Cabecas();
+        o.headsRowJI = Cabecas();
+        o.headsColJI = Cabecas();
+        o.nnzLinhaFisica_ = IndiceCompacto<int>();
+        o.nnzColunaFisica_ = IndiceCompacto<int>();
+        o.apontarAtivaPara(true);
+    }
+
+    // Insere um no que se sabe que ainda nao existe (sem consultar as tabelas)
+    void anexarNovo(int i, int j, double valor) {
+        Node1* novo = nos_.alocar(i, j, valor);
+
+        novo->nextRowIJ = headsRowIJ[i];
+        if (novo->nextRowIJ) novo->nextRowIJ->prevRowIJ = novo;
+        novo->prevRowIJ = nullptr;
+        headsRowIJ.definir(i, novo);
+
+        novo->nextColIJ = headsColIJ[j];
+        if (novo->nextColIJ) novo->nextColIJ->prevColIJ = novo;
+        novo->prevColIJ = nullptr;
+        headsColIJ.definir(j, novo);
+
+        novo->nextRowJI = headsRowJI[j];
+        if (novo->nextRowJI) novo->nextRowJI->prevRowJI = novo;
+        novo->prevRowJI = nullptr;
+        headsRowJI.definir(j, novo);
+
+        novo->nextColJI = headsColJI[i];
+        if (novo->nextColJI) novo->nextColJI->prevColJI = novo;
+        novo->prevColJI = nullptr;
+        headsColJI.definir(i, novo);
+
+        tabelaIJ.emplace(keyIJ(i,j), novo);
+        tabelaJI.emplace(keyJI(j,i), novo);
+        nnzLinhaFisica_.somar(i, 1);
+        nnzColunaFisica_.somar(j, 1);
+        if (hiperAutomatico_ && hiperesparso() && !hiperesparsoCompensa(linhas_, colunas_, (long long)tabelaIJ.size()))
+            mudarModoCabecas(false);
+        if (colunasProprias_ && headsColIJ.hiperesparso() && !colunasCompensam(colunas_, (long long)tabelaIJ.size()))
+            mudarModoColunas(false);
+    }
+
+    // Vale o modo hiperesparso quando a dimensao e grande e os nao-nulos sao
+    // poucos perto dela: cada linha nao vazia custa ~48 bytes na tabela
+    // contra 8 por posicao do vetor, entao com nnz < dimensao/8 sobra memoria
+    static bool hiperesparsoCompensa(long long linhas, long long colunas, long long nnz) {
+        long long dim = max(linhas, colunas);
+        return dim >= LIMIAR_HIPERESPARSO && nnz * 8 < dim;
+    }
+
+    // Modo proprio das colunas, para matrizes que sao pedacos de outra
+    // (fragmentada.h): poucas linhas e todas as colunas, entao S pedacos com
+    // vetores O(colunas) somariam O(S*dimensao). As colunas ficam
+    // hiperesparsas enquanto o pedaco tem menos de colunas/8 nao-nulos, sem o
+    // limite de dimensao: os vetores so aparecem quando os nos ja custam mais.
+    static bool colunasCompensam(long long colunas, long long nnz) {
+        return nnz * 8 < colunas;
+    }
+    static bool modoInicialColunas(long long linhas, long long colunas, long long nnz, bool proprias) {
+        return proprias ? colunasCompensam(colunas, nnz) : hiperesparsoCompensa(linhas, colunas, nnz);
+    }
+
+    // Fase simbolica de this*B (ver produto_esparso.h)
+    void calcularPadrao(const MatrizEsparsaHashDup& B, PadraoProduto& P) const {
+        Cabecas const &headsA = *(this->headsRowAtiva);
+        bool viewIsIJ_A = activeIsIJ();
+        Cabecas const &headsB = *(B.headsRowAtiva);
+        bool viewIsIJ_B = B.activeIsIJ();
+
+        P.iniciar(linhas_, B.colunas_);
+        AcumuladorLinha acc(B.colunas_, (long long)(tabelaIJ.size() + B.tabelaIJ.size()));
+        headsA.paraCadaNaoVazia([&](int i, Node1* cabeca) {
+            for (Node1* na = cabeca; na != nullptr; na = nextRowActive(na, viewIsIJ_A)) {
+                int ak = viewIsIJ_A ? na->j : na->i;
+                if (ak < 0 || ak >= headsB.tamanho()) continue;
+                for (Node1* nb = headsB[ak]; nb != nullptr; nb = nextRowActive(nb, viewIsIJ_B)) {
+                    acc.marcar(viewIsIJ_B ? nb->j : nb->i);
+                }
+            }
+            P.fecharLinha(i, acc);
+        });
+        P.marcarCalculado(versaoPadrao_, !viewIsIJ_A, B.versaoPadrao_, !viewIsIJ_B);
+    }
+
+    // Fase numerica: C ja nasce com o tamanho final e so recebe os valores
+    MatrizEsparsaHashDup multiplicarNumerico(const MatrizEsparsaHashDup& B, const PadraoProduto& P, const Poda& poda) const {
+        MatrizEsparsaHashDup C(linhas_, B.colunas_);
+        C.nos_.reservar((size_t)P.nnz());
+        C.tabelaIJ.reserve((size_t)P.nnz());
+        C.tabelaJI.reserve((size_t)P.nnz());
+
+        Cabecas const &headsA = *(this->headsRowAtiva);
+        bool viewIsIJ_A = activeIsIJ();
+        Cabecas const &headsB = *(B.headsRowAtiva);
+        bool viewIsIJ_B = B.activeIsIJ();
+
+        AcumuladorLinha acc(B.colunas_, (long long)(tabelaIJ.size() + B.tabelaIJ.size()));
+        vector<pair<int, double>> linha;
+        for (size_t r = 0; r < P.linhasPadrao.size(); ++r) {
+            int i = P.linhasPadrao[r];
+            for (Node1* na = headsA[i]; na != nullptr; na = nextRowActive(na, viewIsIJ_A)) {
+                int ak = viewIsIJ_A ? na->j : na->i;
+                if (ak < 0 || ak >= headsB.tamanho()) continue;
+                for (Node1* nb = headsB[ak]; nb != nullptr; nb = nextRowActive(nb, viewIsIJ_B)) {
+                    acc.somar(viewIsIJ_B ? nb->j : nb->i, na->valor * nb->valor);
+                }
+            }
+            linha.clear();
+            for (long long p = P.inicio[r]; p < P.inicio[r + 1]; ++p) {
+                int j = P.colunasPadrao[p];
+                double v = acc.retirar(j);
+                if (!poda.manter(v)) continue;
+                if (poda.limitaLinha()) linha.push_back(make_pair(j, v));
+                else C.anexarNovo(i, j, v);
+            }
+            poda.limitar(linha);
+            for (auto const& e : linha) C.anexarNovo(i, e.first, e.second);
+            acc.limparValores();
+        }
+        return C;
+    }
+
+    // Remove os nos juntados pelas threads (coordenadas fisicas, como o set)
+    void removerNos(const vector<vector<Node1*>>& remover) {
+        setEmLote([&](auto gravarEm) {
+            for (auto const& lista : remover)
+                for (Node1* n : lista) gravarEm(n->i, n->j, 0.0);
+        });
+    }
+
+    // Soma (ou soma dos |valor|) de cada lista de `heads` em paralelo;
+    // porLinha escolhe o ponteiro seguinte (listas de linha ou de coluna)
+    vector<double> somarListas(const Cabecas& heads, int n, bool porLinha, bool absoluto) const {
+        vector<double> s((size_t)max(0, n), 0.0);
+        bool viewIsIJ = activeIsIJ();
+        heads.paraCadaNaoVaziaParalelo(threadsPara((long long)tabelaIJ.size(), 1 << 15), [&](int k, Node1* cabeca, int) {
+            double soma = 0.0;
+            for (Node1* p = cabeca; p != nullptr; p = porLinha ? nextRowActive(p, viewIsIJ) : nextColActive(p, viewIsIJ))
+                soma += absoluto ? fabs(p->valor) : p->valor;
+            s[k] = soma;
+        });
+        return s;
+    }
+
+    static vector<int> copiarContadores(const IndiceCompacto<int>& c, int n) {
+        vector<int> v((size_t)max(0, n), 0);
+        c.paraCadaNaoVazia([&](int k, int q) { if (k < n) v[k] = q; });
+        return v;
+    }
+
+    // MatrizCSR::combinar direto das listas, para o modo hiperesparso: so as
+    // linhas nao vazias sao visitadas (uniao ou intersecao das duas) e C e
+    // montada por anexarNovo, sem os vetores O(linhas) da CSR. Cada linha e
+    // ordenada por coluna e intercalada com a mesma semantica do combinar.
+    template <typename Op>
+    MatrizEsparsaHashDup combinarListas(const MatrizEsparsaHashDup& B, bool uniao, Op op, const Poda& poda) const {
+        vector<int> la, lb, linhas;
+        headsRowAtiva->paraCadaNaoVazia([&](int i, Node1*) { la.push_back(i); });
+        B.headsRowAtiva->paraCadaNaoVazia([&](int i, Node1*) { lb.push_back(i); });
+        if (uniao) set_union(la.begin(), la.end(), lb.begin(), lb.end(), back_inserter(linhas));
+        else set_intersection(la.begin(), la.end(), lb.begin(), lb.end(), back_inserter(linhas));
+
+        auto lerLinha = [](const MatrizEsparsaHashDup& M, int i, vector<pair<int, double>>& l) {
+            bool viewIsIJ = M.activeIsIJ();
+            l.clear();
+            if (i >= M.headsRowAtiva->tamanho()) return;
+            for (Node1* n = (*M.headsRowAtiva)[i]; n != nullptr; n = nextRowActive(n, viewIsIJ))
+                l.push_back(make_pair(viewIsIJ ? n->j : n->i, n->valor));
+            sort(l.begin(), l.end());
+        };
+        struct Elemento { int i, j; double v; };
+        int threads = threadsPara((long long)(tabelaIJ.size() + B.tabelaIJ.size()), 1 << 15);
+        vector<vector<Elemento>> saida(max(1, threads));
+        paraleloPara((long long)linhas.size(), threads, [&](long long ini, long long fim, int t) {
+            vector<pair<int, double>> a, b, linha;
+            for (long long r = ini; r < fim; ++r) {
+                int i = linhas[r];
+                lerLinha(*this, i, a);
+                lerLinha(B, i, b);
+                linha.clear();
+                auto emitir = [&](int j, double v) { if (poda.manter(v)) linha.push_back(make_pair(j, v)); };
+                size_t p = 0, q = 0;
+                while (p < a.size() && q < b.size()) {
+                    if (a[p].first == b[q].first) { emitir(a[p].first, op(a[p].second, b[q].second)); ++p; ++q; }
+                    else if (a[p].first < b[q].first) { if (uniao) emitir(a[p].first, op(a[p].second, 0.0)); ++p; }
+                    else { if (uniao) emitir(b[q].first, op(0.0, b[q].second)); ++q; }
+                }
+                if (uniao) {
+                    for (; p < a.size(); ++p) emitir(a[p].first, op(a[p].second, 0.0));
+                    for (; q < b.size(); ++q) emitir(b[q].first, op(0.0, b[q].second));
+                }
+                poda.limitar(linha);
+                for (auto const& e : linha)
+                    if (e.second != 0.0) saida[t].push_back({i, e.first, e.second});
+            }
+        });
+
+        size_t nnz = 0;
+        for (auto const& l : saida) nnz += l.size();
+        MatrizEsparsaHashDup C(linhas_, colunas_, (long long)nnz, colunasProprias_);
+        C.nos_.reservar(nnz);
+        C.tabelaIJ.reserve(nnz);
+        C.tabelaJI.reserve(nnz);
+        for (auto const& l : saida)
+            for (auto const& e : l) C.anexarNovo(e.i, e.j, e.v);
+        return C;
+    }
+
 public:
+    // dimensao a partir da qual o modo hiperesparso e escolhido sozinho
+    static const long long LIMIAR_HIPERESPARSO = 1 << 20;
+
     //construtor
-    MatrizEsparsaHashDup(int linhas, int colunas)
+    // Com dimensao >= LIMIAR_HIPERESPARSO a matriz nasce hiperesparsa e passa
+    // para os vetores quando os nao-nulos chegam a dimensao/8
+    // Com colunasProprias os indices das colunas seguem colunasCompensam.
+    MatrizEsparsaHashDup(int linhas, int colunas, long long nnzEsperado = 0, bool colunasProprias = false)
         : linhas_(linhas), colunas_(colunas),
-          headsRowIJ(max(1, linhas), nullptr),
-          headsColIJ(max(1, colunas), nullptr),
-          headsRowJI(max(1, colunas), nullptr),
-          headsColJI(max(1, linhas), nullptr)
+          headsRowIJ(linhas, hiperesparsoCompensa(linhas, colunas, nnzEsperado)),
+          headsColIJ(colunas, modoInicialColunas(linhas, colunas, nnzEsperado, colunasProprias)),
+          headsRowJI(colunas, modoInicialColunas(linhas, colunas, nnzEsperado, colunasProprias)),
+          headsColJI(linhas, hiperesparsoCompensa(linhas, colunas, nnzEsperado)),
+          nnzLinhaFisica_(linhas, hiperesparsoCompensa(linhas, colunas, nnzEsperado)),
+          nnzColunaFisica_(colunas, modoInicialColunas(linhas, colunas, nnzEsperado, colunasProprias)),
+          colunasProprias_(colunasProprias)
     {
+        versaoPadrao_ = novaVersaoPadrao();
         tabelaFisicaIJ = &tabelaIJ;
         tabelaFisicaJI = &tabelaJI;
 
@@ -78,16 +349,95 @@ public:
         headsColAtiva = &headsColIJ;
     }
 
-    ~MatrizEsparsaHashDup() {
-        for (auto &p : tabelaIJ) {
-            delete p.second;
-        }
-        tabelaIJ.clear();
-        tabelaJI.clear();
+    // Construcao em bloco a partir de uma CSR: tabelas e pool reservados com o
+    // nnz final e insercao direta, sem as consultas do set
+    explicit MatrizEsparsaHashDup(const MatrizCSR& M, bool colunasProprias = false)
+        : MatrizEsparsaHashDup(M.getLinhas(), M.getColunas(), (long long)M.getNaoNulos(), colunasProprias)
+    {
+        size_t nnz = M.getNaoNulos();
+        nos_.reservar(nnz);
+        tabelaIJ.reserve(nnz);
+        tabelaJI.reserve(nnz);
+        M.paraCadaElemento([&](int i, int j, double v) {
+            if (v != 0.0) anexarNovo(i, j, v);
+        });
+    }
+
+    // Qualquer outro formato com paraCSR() (MatrizDensa, TreeDup): converte
+    // em bloco (CSR em paralelo, linhas ordenadas) e constroi como acima
+    template <typename Matriz, typename = decltype(declval<const Matriz&>().paraCSR())>
+    explicit MatrizEsparsaHashDup(const Matriz& M)
+        : MatrizEsparsaHashDup(M.paraCSR()) {}
+
+    // os nos sao liberados junto com os blocos do pool
+    ~MatrizEsparsaHashDup() {}
+
+    // copias implicitas sao proibidas (seria facil duplicar uma matriz grande sem querer);
+    // para copiar use clonar()
+    MatrizEsparsaHashDup(const MatrizEsparsaHashDup&) = delete;
+    MatrizEsparsaHashDup& operator=(const MatrizEsparsaHashDup&) = delete;
+
+    //MOVER: O(1), so troca a posse dos blocos, tabelas e cabecas
+    MatrizEsparsaHashDup(MatrizEsparsaHashDup&& o) noexcept {
+        moverDe(o);
+    }
+    MatrizEsparsaHashDup& operator=(MatrizEsparsaHashDup&& o) noexcept {
+        if (this != &o) moverDe(o);
+        return *this;
+    }
+
+    //CLONAR (copia profunda)
+    // Copia os blocos de nos com memcpy e corrige os 8 ponteiros de cada no,
+    // as cabecas e os valores das tabelas, sem reinserir elemento a elemento.
+    MatrizEsparsaHashDup clonar() const {
+        MatrizEsparsaHashDup C(0, 0);
+        C.linhas_ = linhas_;
+        C.colunas_ = colunas_;
+        C.versaoPadrao_ = versaoPadrao_;
+
+        C.nos_.copiarBlocosDe(nos_);
+        const PoolNos<Node1>& origem = nos_;
+        PoolNos<Node1>& destino = C.nos_;
+        destino.paraCadaSlot([&](Node1* n) {
+            n->prevRowIJ = destino.traduzir(origem, n->prevRowIJ);
+            n->nextRowIJ = destino.traduzir(origem, n->nextRowIJ);
+            n->prevColIJ = destino.traduzir(origem, n->prevColIJ);
+            n->nextColIJ = destino.traduzir(origem, n->nextColIJ);
+            n->prevRowJI = destino.traduzir(origem, n->prevRowJI);
+            n->nextRowJI = destino.traduzir(origem, n->nextRowJI);
+            n->prevColJI = destino.traduzir(origem, n->prevColJI);
+            n->nextColJI = destino.traduzir(origem, n->nextColJI);
+        });
+
+        auto copiarCabecas = [&](Cabecas& dst, const Cabecas& src) {
+            dst = src;
+            dst.transformar([&](Node1* n) { return destino.traduzir(origem, n); });
+        };
+        copiarCabecas(C.headsRowIJ, headsRowIJ);
+        copiarCabecas(C.headsColIJ, headsColIJ);
+        copiarCabecas(C.headsRowJI, headsRowJI);
+        copiarCabecas(C.headsColJI, headsColJI);
+        C.nnzLinhaFisica_ = nnzLinhaFisica_;
+        C.nnzColunaFisica_ = nnzColunaFisica_;
+        C.hiperAutomatico_ = hiperAutomatico_;
+        C.colunasProprias_ = colunasProprias_;
+
+        C.tabelaIJ = tabelaIJ;
+        for (auto &p : C.tabelaIJ) p.second = destino.traduzir(origem, p.second);
+        C.tabelaJI = tabelaJI;
+        for (auto &p : C.tabelaJI) p.second = destino.traduzir(origem, p.second);
+
+        C.apontarAtivaPara(activeIsIJ());
+        return C;
     }
 
     int getLinhas() const { return linhas_; }
     int getColunas() const { return colunas_; }
+    size_t getNaoNulos() const { return tabelaIJ.size(); }
+
+    // muda sempre que um nao-nulo e inserido ou removido (nao muda com valores)
+    uint64_t versaoPadrao() const { return versaoPadrao_; }
+    bool estaTransposta() const { return !activeIsIJ(); }
 
     static Node1* nextRowActive(Node1* n, bool viewIsIJ) {
         return viewIsIJ ? n->nextRowIJ : n->nextRowJI;
@@ -107,9 +457,111 @@ public:
         headsColAtiva = &headsColJI;
     }
 
-    //INSERIR OU ATUALIZAR ELEMENTO
-    void set(int i, int j, double valor) {
-        if (i < 0 || j < 0) return;
+    // nao-nulos da linha i / coluna j na orientacao ativa, O(1)
+    int nnzNaLinha(int i) const {
+        IndiceCompacto<int> const &v = activeIsIJ() ? nnzLinhaFisica_ : nnzColunaFisica_;
+        return (i < 0 || i >= v.tamanho()) ? 0 : v[i];
+    }
+    int nnzNaColuna(int j) const {
+        IndiceCompacto<int> const &v = activeIsIJ() ? nnzColunaFisica_ : nnzLinhaFisica_;
+        return (j < 0 || j >= v.tamanho()) ? 0 : v[j];
+    }
+
+    //MODO HIPERESPARSO
+    bool hiperesparso() const { return headsRowIJ.hiperesparso(); }
+
+    // forca um dos modos (desliga a troca automatica)
+    void definirHiperesparso(bool hiper) {
+        hiperAutomatico_ = false;
+        mudarModoCabecas(hiper);
+    }
+
+private:
+    // com colunasProprias_ so as linhas fisicas mudam aqui
+    void mudarModoCabecas(bool hiper) {
+        headsRowIJ.mudarModo(hiper);
+        headsColJI.mudarModo(hiper);
+        nnzLinhaFisica_.mudarModo(hiper);
+        if (!colunasProprias_) mudarModoColunas(hiper);
+    }
+    void mudarModoColunas(bool hiper) {
+        headsColIJ.mudarModo(hiper);
+        headsRowJI.mudarModo(hiper);
+        nnzColunaFisica_.mudarModo(hiper);
+    }
+
+public:
+    //USO DE MEMORIA (O(blocos do pool), nao percorre os elementos)
+    // As quatro listas de cabecas e os dois contadores sao O(linhas + colunas)
+    // mesmo com a matriz vazia, a nao ser no modo hiperesparso
+    UsoMemoria usoMemoria() const {
+        UsoMemoria u;
+        u.objeto = sizeof(*this);
+        u.nos = nos_.bytesReservados();
+        u.nosVivos = nos_.tamanho();
+        u.nosLivres = nos_.livres();
+        u.tabelas = bytesTabelaHash(tabelaIJ) + bytesTabelaHash(tabelaJI);
+        u.baldesIJ = tabelaIJ.bucket_count();
+        u.baldesJI = tabelaJI.bucket_count();
+        u.fatorCargaIJ = tabelaIJ.load_factor();
+        u.fatorCargaJI = tabelaJI.load_factor();
+        u.cabecas = headsRowIJ.bytes() + headsColIJ.bytes() + headsRowJI.bytes() + headsColJI.bytes()
+                  + nnzLinhaFisica_.bytes() + nnzColunaFisica_.bytes();
+        u.valores = tabelaIJ.size() * sizeof(double);
+        return u;
+    }
+
+    // contagens por linha/coluna para o planejador de cadeias (cadeia.h)
+    EstatisticasPadrao estatisticas() const {
+        EstatisticasPadrao E;
+        E.linhas = linhas_;
+        E.colunas = colunas_;
+        IndiceCompacto<int> const &porLinha = activeIsIJ() ? nnzLinhaFisica_ : nnzColunaFisica_;
+        IndiceCompacto<int> const &porColuna = activeIsIJ() ? nnzColunaFisica_ : nnzLinhaFisica_;
+        porLinha.paraCadaNaoVazia([&](int i, int c) { E.porLinha.push_back(make_pair(i, (double)c)); });
+        porColuna.paraCadaNaoVazia([&](int j, int c) { E.porColuna.push_back(make_pair(j, (double)c)); });
+        E.nnz = (double)tabelaIJ.size();
+        return E;
+    }
+
+    //PERCORRER ELEMENTOS (sempre na orientacao ativa)
+    // f(j, valor) para cada nao-nulo da linha i
+    template <typename F>
+    void paraCadaNaLinha(int i, F f) const {
+        if (i < 0 || i >= headsRowAtiva->tamanho()) return;
+        bool viewIsIJ = activeIsIJ();
+        for (Node1* n = (*headsRowAtiva)[i]; n != nullptr; n = nextRowActive(n, viewIsIJ))
+            f(viewIsIJ ? n->j : n->i, n->valor);
+    }
+
+    // f(i, valor) para cada nao-nulo da coluna j
+    template <typename F>
+    void paraCadaNaColuna(int j, F f) const {
+        if (j < 0 || j >= headsColAtiva->tamanho()) return;
+        bool viewIsIJ = activeIsIJ();
+        for (Node1* n = (*headsColAtiva)[j]; n != nullptr; n = nextColActive(n, viewIsIJ))
+            f(viewIsIJ ? n->i : n->j, n->valor);
+    }
+
+    // f(i) para cada linha com pelo menos um nao-nulo, em ordem crescente
+    template <typename F>
+    void paraCadaLinhaNaoVazia(F f) const {
+        headsRowAtiva->paraCadaNaoVazia([&](int i, Node1*) { f(i); });
+    }
+
+    // f(i, j, valor) para todos os nao-nulos, agrupados por linha
+    template <typename F>
+    void paraCadaElemento(F f) const {
+        paraCadaLinhaNaoVazia([&](int i) {
+            paraCadaNaLinha(i, [&](int j, double v) { f(i, j, v); });
+        });
+    }
+
+private:
+    // corpo do set sem o carimbo de versao: devolve se o padrao mudou
+    // (insercao ou remocao), para quem insere em lote carimbar uma vez so
+    bool gravar(int i, int j, double valor) {
+        if (i < 0 || j < 0) return false;
 
         uint64_t kIJ = keyIJ(i,j);
         uint64_t kJI = keyJI(j,i);
@@ -119,56 +571,53 @@ public:
             Node1* node = itIJ->second;
             if (valor == 0.0) {
                 if (node->prevRowIJ) node->prevRowIJ->nextRowIJ = node->nextRowIJ;
-                else headsRowIJ[node->i] = node->nextRowIJ;
+                else headsRowIJ.definir(node->i, node->nextRowIJ);
                 if (node->nextRowIJ) node->nextRowIJ->prevRowIJ = node->prevRowIJ;
 
                 if (node->prevColIJ) node->prevColIJ->nextColIJ = node->nextColIJ;
-                else headsColIJ[node->j] = node->nextColIJ;
+                else headsColIJ.definir(node->j, node->nextColIJ);
                 if (node->nextColIJ) node->nextColIJ->prevColIJ = node->prevColIJ;
 
                 if (node->prevRowJI) node->prevRowJI->nextRowJI = node->nextRowJI;
-                else headsRowJI[node->j] = node->nextRowJI;
+                else headsRowJI.definir(node->j, node->nextRowJI);
                 if (node->nextRowJI) node->nextRowJI->prevRowJI = node->prevRowJI;
 
                 if (node->prevColJI) node->prevColJI->nextColJI = node->nextColJI;
-                else headsColJI[node->i] = node->nextColJI;
+                else headsColJI.definir(node->i, node->nextColJI);
                 if (node->nextColJI) node->nextColJI->prevColJI = node->prevColJI;
 
                 tabelaIJ.erase(kIJ);
                 tabelaJI.erase(kJI);
-                delete node;
-            } else {
-                node->valor = valor;
+                nnzLinhaFisica_.somar(node->i, -1);
+                nnzColunaFisica_.somar(node->j, -1);
+                nos_.liberar(node);
+                return true;
             }
-            return;
+            node->valor = valor;
+            return false;
         }
 
-        if (valor == 0.0) return;
-
-        Node1* novo = new Node1(i, j, valor);
+        if (valor == 0.0) return false;
 
-        novo->nextRowIJ = headsRowIJ[i];
-        if (headsRowIJ[i]) headsRowIJ[i]->prevRowIJ = novo;
-        novo->prevRowIJ = nullptr;
-        headsRowIJ[i] = novo;
-
-        novo->nextColIJ = headsColIJ[j];
-        if (headsColIJ[j]) headsColIJ[j]->prevColIJ = novo;
-        novo->prevColIJ = nullptr;
-        headsColIJ[j] = novo;
-
-        novo->nextRowJI = headsRowJI[j];
-        if (headsRowJI[j]) headsRowJI[j]->prevRowJI = novo;
-        novo->prevRowJI = nullptr;
-        headsRowJI[j] = novo;
+        anexarNovo(i, j, valor);
+        return true;
+    }
 
-        novo->nextColJI = headsColJI[i];
-        if (headsColJI[i]) headsColJI[i]->prevColJI = novo;
-        novo->prevColJI = nullptr;
-        headsColJI[i] = novo;
+public:
+    //INSERIR OU ATUALIZAR ELEMENTO
+    void set(int i, int j, double valor) {
+        if (gravar(i, j, valor)) versaoPadrao_ = novaVersaoPadrao();
+    }
 
-        tabelaIJ[kIJ] = novo;
-        tabelaJI[kJI] = novo;
+    // Varios set seguidos com um carimbo de versao so no fim: f(inserir)
+    // chama inserir(i, j, valor) para cada posicao. O contador de versoes e
+    // global (atomico), entao um carimbo por insercao faria construcoes em
+    // paralelo de matrizes diferentes disputarem a mesma linha de cache.
+    template <typename F>
+    void setEmLote(F f) {
+        bool mudou = false;
+        f([&](int i, int j, double valor) { mudou |= gravar(i, j, valor); });
+        if (mudou) versaoPadrao_ = novaVersaoPadrao();
     }
 
     //ACESSAR ELEMENTO
@@ -179,7 +628,7 @@ public:
             auto it = tabelaIJ.find(k);
             return (it == tabelaIJ.end() ? 0.0 : it->second->valor);
         } else {
-            uint64_t k = keyJI(j,i);
+            uint64_t k = keyJI(i,j); // (i,j) da visao = (j,i) fisico
             auto it = tabelaJI.find(k);
             return (it == tabelaJI.end() ? 0.0 : it->second->valor);
         }
@@ -199,6 +648,58 @@ public:
         swap(linhas_, colunas_);
     }
 
+    //CONVERTER PARA CSR (orientacao ativa, colunas ordenadas dentro de cada linha)
+    // Os tamanhos das linhas vem dos contadores, entao cada linha e escrita
+    // direto na sua faixa, em paralelo. So as linhas nao vazias sao visitadas
+    // (no modo hiperesparso o custo O(linhas) fica so no vetor de inicio, que
+    // e do formato; por isso as operacoes internas nao passam por aqui nesse
+    // modo).
+    MatrizCSR paraCSR() const {
+        int L = linhas_;
+        vector<long long> inicio((size_t)L + 1, 0);
+        (activeIsIJ() ? nnzLinhaFisica_ : nnzColunaFisica_).paraCadaNaoVazia([&](int i, int c) {
+            if (i < L) inicio[i + 1] = c;
+        });
+        for (int i = 0; i < L; ++i) inicio[i + 1] += inicio[i];
+        long long nnz = inicio[L];
+
+        vector<int> cols((size_t)nnz);
+        vector<double> vals((size_t)nnz);
+        bool viewIsIJ = activeIsIJ();
+        int threads = threadsPara(nnz, 1 << 15);
+        vector<vector<pair<int, double>>> linha(max(1, threads));
+        headsRowAtiva->paraCadaNaoVaziaParalelo(threads, [&](int i, Node1* cabeca, int t) {
+            if (i >= L) return;
+            vector<pair<int, double>>& l = linha[t];
+            l.clear();
+            for (Node1* n = cabeca; n != nullptr; n = nextRowActive(n, viewIsIJ))
+                l.push_back(make_pair(viewIsIJ ? n->j : n->i, n->valor));
+            sort(l.begin(), l.end());
+            long long p = inicio[i];
+            for (auto const& e : l) {
+                cols[p] = e.first;
+                vals[p++] = e.second;
+            }
+        });
+        return MatrizCSR(L, colunas_, std::move(inicio), std::move(cols), std::move(vals));
+    }
+
+    //TRANSPOSTA EXPLICITA
+    // Monta uma matriz nova ja na outra orientacao (ordenacao por contagem em
+    // paralelo, ver MatrizCSR::transposta), em vez de so trocar os ponteiros
+    // como o transpor(). No modo hiperesparso os nos sao anexados ja
+    // trocados, sem a CSR e o histograma O(colunas) da transposta dela.
+    MatrizEsparsaHashDup transpostaExplicita() const {
+        if (!hiperesparso()) return MatrizEsparsaHashDup(paraCSR().transposta());
+        size_t nnz = tabelaIJ.size();
+        MatrizEsparsaHashDup C(colunas_, linhas_, (long long)nnz);
+        C.nos_.reservar(nnz);
+        C.tabelaIJ.reserve(nnz);
+        C.tabelaJI.reserve(nnz);
+        paraCadaElemento([&](int i, int j, double v) { C.anexarNovo(j, i, v); });
+        return C;
+    }
+
     //SOMA DE MATRIZES
     MatrizEsparsaHashDup somar(const MatrizEsparsaHashDup& B) const {
         MatrizEsparsaHashDup C(linhas_, colunas_);
@@ -206,36 +707,88 @@ public:
         bool viewIsIJ_A = (this->tabelaAtiva == &this->tabelaIJ);
         bool viewIsIJ_B = (B.tabelaAtiva == &B.tabelaIJ);
 
-        vector<Node1*> const &headsA = *(this->headsRowAtiva);
-        for (int i = 0; i < (int)headsA.size(); ++i) {
-            for (Node1* n = headsA[i]; n != nullptr; n = (viewIsIJ_A ? n->nextRowIJ : n->nextRowJI)) {
+        this->headsRowAtiva->paraCadaNaoVazia([&](int, Node1* cabeca) {
+            for (Node1* n = cabeca; n != nullptr; n = (viewIsIJ_A ? n->nextRowIJ : n->nextRowJI)) {
                 int ii = viewIsIJ_A ? n->i : n->j;
                 int jj = viewIsIJ_A ? n->j : n->i;
                 C.set(ii, jj, n->valor);
             }
-        }
+        });
 
-        vector<Node1*> const &headsB = *(B.headsRowAtiva);
-        for (int i = 0; i < (int)headsB.size(); ++i) {
-            for (Node1* n = headsB[i]; n != nullptr; n = (viewIsIJ_B ? n->nextRowIJ : n->nextRowJI)) {
+        B.headsRowAtiva->paraCadaNaoVazia([&](int, Node1* cabeca) {
+            for (Node1* n = cabeca; n != nullptr; n = (viewIsIJ_B ? n->nextRowIJ : n->nextRowJI)) {
                 int ii = viewIsIJ_B ? n->i : n->j;
                 int jj = viewIsIJ_B ? n->j : n->i;
                 double atual = C.getElemento(ii, jj);
                 C.set(ii, jj, atual + n->valor);
             }
-        }
+        });
 
         return C;
     }
 
+    // Soma com poda: linhas das duas em CSR, intercaladas ja descartando o que
+    // a `poda` tira (MatrizCSR::somar), e C montada em bloco. Hiperesparsas:
+    // a mesma intercalacao direto das listas (combinarListas).
+    MatrizEsparsaHashDup somar(const MatrizEsparsaHashDup& B, const Poda& poda) const {
+        if (hiperesparso() || B.hiperesparso())
+            return combinarListas(B, true, [](double a, double b) { return a + b; }, poda);
+        return MatrizEsparsaHashDup(paraCSR().somar(B.paraCSR(), poda), colunasProprias_);
+    }
+
+    //PODA
+    // Uma passada paralela acha o que sai e os nos sao desligados no lugar
+    // (sem remontar: nada O(dimensao), e a orientacao e o modo escolhido a
+    // mao ficam como estavam). Se saiu muito (>= 1/4 do nnz) as tabelas sao
+    // encolhidas; os nos soltos voltam para o pool. Devolve quantos sairam.
+    size_t podar(const Poda& poda) {
+        bool viewIsIJ = activeIsIJ();
+        int threads = threadsPara((long long)tabelaIJ.size(), 1 << 15);
+        vector<vector<Node1*>> fora(max(1, threads));
+        headsRowAtiva->paraCadaNaoVaziaParalelo(threads, [&](int, Node1* cabeca, int t) {
+            vector<pair<int, Node1*>> nos;
+            for (Node1* n = cabeca; n != nullptr; n = nextRowActive(n, viewIsIJ)) {
+                if (!poda.manter(n->valor)) fora[t].push_back(n);
+                else if (poda.limitaLinha()) nos.push_back(make_pair(viewIsIJ ? n->j : n->i, n));
+            }
+            if ((int)nos.size() <= poda.maioresPorLinha) return;
+            // limite por linha: sai o que nao esta entre os k maiores
+            sort(nos.begin(), nos.end());
+            vector<pair<int, double>> ficam;
+            for (auto const& e : nos) ficam.push_back(make_pair(e.first, e.second->valor));
+            poda.limitar(ficam);
+            size_t f = 0;
+            for (auto const& e : nos) {
+                if (f < ficam.size() && ficam[f].first == e.first) ++f;
+                else fora[t].push_back(e.second);
+            }
+        });
+        size_t total = 0;
+        for (auto const& l : fora) total += l.size();
+        if (total == 0) return 0;
+        bool encolher = total * 4 >= tabelaIJ.size();
+        removerNos(fora);
+        if (encolher) {
+            tabelaIJ.rehash(0);
+            tabelaJI.rehash(0);
+            // o que sobrou pode caber no modo hiperesparso (so se for automatico)
+            if (hiperAutomatico_ && !hiperesparso() && hiperesparsoCompensa(linhas_, colunas_, (long long)tabelaIJ.size()))
+                mudarModoCabecas(true);
+            if (colunasProprias_ && !headsColIJ.hiperesparso() && colunasCompensam(colunas_, (long long)tabelaIJ.size()))
+                mudarModoColunas(true);
+        }
+        return total;
+    }
+    size_t podar(double tolerancia) { return podar(Poda(tolerancia)); }
+
     //MULTIPLICACAO POR ESCALAR
     /*
     MatrizEsparsaHashDup multiplicarEscalar(double escalar) const {
         MatrizEsparsaHashDup R(linhas_, colunas_);
 
-        vector<Node1*> const &headsA = *(this->headsRowAtiva);
+        Cabecas const &headsA = *(this->headsRowAtiva);
         bool viewIsIJ_A = (this->tabelaAtiva == &this->tabelaIJ);
-        for (int i = 0; i < (int)headsA.size(); ++i) {
+        for (int i = 0; i < (int)headsA.tamanho(); ++i) {
             for (Node1* n = headsA[i]; n != nullptr; n = (viewIsIJ_A ? n->nextRowIJ : n->nextRowJI)) {
                 int ii = viewIsIJ_A ? n->i : n->j;
                 int jj = viewIsIJ_A ? n->j : n->i;
@@ -245,43 +798,196 @@ public:
         return R;
     } */
    void multiplicarEscalar(double escalar) {
-        vector<Node1*> const &headsA = *(this->headsRowAtiva);
         bool viewIsIJ_A = (this->tabelaAtiva == &this->tabelaIJ);
 
-        for (int idx = 0; idx < (int)headsA.size(); ++idx) {
-            for (Node1* n = headsA[idx];
+        this->headsRowAtiva->paraCadaNaoVazia([&](int, Node1* cabeca) {
+            for (Node1* n = cabeca;
                 n != nullptr;
                 n = (viewIsIJ_A ? n->nextRowIJ : n->nextRowJI))
             {
                 n->valor *= escalar;
             }
-        }
+        });
+    }
+
+    //OPERACOES ELEMENTO A ELEMENTO
+    // Binarias: as duas matrizes viram CSR (linhas ordenadas, em paralelo), as
+    // linhas sao intercaladas (MatrizCSR::combinar) e o resultado e montado em
+    // bloco, sem uma consulta as tabelas por elemento. No modo hiperesparso
+    // a intercalacao e feita direto das listas (combinarListas).
+    MatrizEsparsaHashDup produtoHadamard(const MatrizEsparsaHashDup& B) const {
+        if (hiperesparso() || B.hiperesparso())
+            return combinarListas(B, false, [](double a, double b) { return a * b; }, Poda());
+        return MatrizEsparsaHashDup(paraCSR().produtoHadamard(B.paraCSR()), colunasProprias_);
     }
 
+    // posicao ausente de um dos lados vale 0
+    MatrizEsparsaHashDup maximoElemento(const MatrizEsparsaHashDup& B) const {
+        if (hiperesparso() || B.hiperesparso())
+            return combinarListas(B, true, [](double a, double b) { return max(a, b); }, Poda());
+        return MatrizEsparsaHashDup(paraCSR().maximoElemento(B.paraCSR()), colunasProprias_);
+    }
+    MatrizEsparsaHashDup minimoElemento(const MatrizEsparsaHashDup& B) const {
+        if (hiperesparso() || B.hiperesparso())
+            return combinarListas(B, true, [](double a, double b) { return min(a, b); }, Poda());
+        return MatrizEsparsaHashDup(paraCSR().minimoElemento(B.paraCSR()), colunasProprias_);
+    }
 
-    //MULTIPLICACAO DE MATRIZES
-    MatrizEsparsaHashDup multiplicar(const MatrizEsparsaHashDup& B) const {
-        MatrizEsparsaHashDup C(linhas_, B.colunas_);
+    // valor = f(valor) nos nao-nulos, em paralelo por faixas de linhas (os
+    // zeros nao sao visitados: f(0) deve ser 0). Os que viram zero saem.
+    template <typename F>
+    void aplicar(F f) {
+        bool viewIsIJ = activeIsIJ();
+        int threads = threadsPara((long long)tabelaIJ.size(), 1 << 15);
+        vector<vector<Node1*>> zerados(threads);
+        headsRowAtiva->paraCadaNaoVaziaParalelo(threads, [&](int, Node1* cabeca, int t) {
+            for (Node1* n = cabeca; n != nullptr; n = nextRowActive(n, viewIsIJ)) {
+                n->valor = f(n->valor);
+                if (n->valor == 0.0) zerados[t].push_back(n);
+            }
+        });
+        removerNos(zerados);
+    }
 
-        vector<Node1*> const &headsA = *(this->headsRowAtiva);
-        bool viewIsIJ_A = (this->tabelaAtiva == &this->tabelaIJ);
-        vector<Node1*> const &headsB = *(B.headsRowAtiva);
-        bool viewIsIJ_B = (B.tabelaAtiva == &B.tabelaIJ);
+    // A o= M em place: sai o que nao esta no padrao de M (busca binaria na
+    // linha da CSR); com usarValores=true o que fica e multiplicado por M
+    void mascarar(const MatrizCSR& M, bool usarValores = false) {
+        mascararPorConsulta(M, usarValores);
+    }
 
-        for (int i = 0; i < (int)headsA.size(); ++i) {
-            for (Node1* na = headsA[i]; na != nullptr; na = (viewIsIJ_A ? na->nextRowIJ : na->nextRowJI)) {
-                int ai = viewIsIJ_A ? na->i : na->j;
-                int ak = viewIsIJ_A ? na->j : na->i;
-                if (ak < 0 || ak >= (int)headsB.size()) continue;
-                for (Node1* nb = headsB[ak]; nb != nullptr; nb = (viewIsIJ_B ? nb->nextRowIJ : nb->nextRowJI)) {
-                    int bj = viewIsIJ_B ? nb->j : nb->i;
-                    double atual = C.getElemento(ai, bj);
-                    C.set(ai, bj, atual + na->valor * nb->valor);
-                }
+    // M HashDup: consulta direto na tabela dela, sem passar por CSR (que
+    // custaria O(linhas) no modo hiperesparso). A o= A le os valores que
+    // estao sendo escritos: nesse caso vai pela copia em CSR.
+    void mascarar(const MatrizEsparsaHashDup& M, bool usarValores = false) {
+        if (&M == this) mascararPorConsulta(M.paraCSR(), usarValores);
+        else mascararPorConsulta(M, usarValores);
+    }
+
+    // M de outro formato esparso (TreeDup): convertida uma vez
+    template <typename Mascara>
+    void mascarar(const Mascara& M, bool usarValores = false) {
+        mascarar(M.paraCSR(), usarValores);
+    }
+
+    // corpo comum: M.getElemento(i, j) nas coordenadas da orientacao ativa
+    template <typename Consulta>
+    void mascararPorConsulta(const Consulta& M, bool usarValores) {
+        bool viewIsIJ = activeIsIJ();
+        int threads = threadsPara((long long)tabelaIJ.size(), 1 << 15);
+        vector<vector<Node1*>> fora(threads);
+        headsRowAtiva->paraCadaNaoVaziaParalelo(threads, [&](int i, Node1* cabeca, int t) {
+            for (Node1* n = cabeca; n != nullptr; n = nextRowActive(n, viewIsIJ)) {
+                double m = M.getElemento(i, viewIsIJ ? n->j : n->i);
+                if (usarValores) n->valor *= m;
+                if (m == 0.0 || n->valor == 0.0) fora[t].push_back(n);
             }
-        }
+        });
+        removerNos(fora);
+    }
+    //REDUCOES (orientacao ativa, em paralelo por faixas de linhas/colunas)
+    // As somas de coluna percorrem as listas de coluna da orientacao ativa:
+    // custam o mesmo que as de linha, inclusive depois do transpor()
+    vector<double> somaLinhas() const {
+        return somarListas(*headsRowAtiva, linhas_, true, false);
+    }
+    vector<double> somaColunas() const {
+        return somarListas(*headsColAtiva, colunas_, false, false);
+    }
+
+    double normaFrobenius() const {
+        bool viewIsIJ = activeIsIJ();
+        int threads = threadsPara((long long)tabelaIJ.size(), 1 << 15);
+        vector<double> parciais(max(1, threads), 0.0);
+        headsRowAtiva->paraCadaNaoVaziaParalelo(threads, [&](int, Node1* cabeca, int t) {
+            double soma = 0.0;
+            for (Node1* n = cabeca; n != nullptr; n = nextRowActive(n, viewIsIJ)) soma += n->valor * n->valor;
+            parciais[t] += soma;
+        });
+        // parciais somadas na ordem das faixas, como no reduzirParalelo
+        double total = 0.0;
+        for (double p : parciais) total += p;
+        return sqrt(total);
+    }
+
+    // norma 1 (induzida): maior soma absoluta de coluna
+    double normaL1() const {
+        vector<double> c = somarListas(*headsColAtiva, colunas_, false, true);
+        return c.empty() ? 0.0 : *max_element(c.begin(), c.end());
+    }
 
+    // norma infinito (induzida): maior soma absoluta de linha
+    double normaInfinito() const {
+        vector<double> l = somarListas(*headsRowAtiva, linhas_, true, true);
+        return l.empty() ? 0.0 : *max_element(l.begin(), l.end());
+    }
+
+    // so as linhas nao vazias consultam a tabela
+    double traco() const {
+        double soma = 0.0;
+        int d = min(linhas_, colunas_);
+        headsRowAtiva->paraCadaNaoVazia([&](int i, Node1*) {
+            if (i < d) soma += getElemento(i, i);
+        });
+        return soma;
+    }
+
+    // copias dos contadores da orientacao ativa
+    vector<int> nnzPorLinha() const {
+        return copiarContadores(activeIsIJ() ? nnzLinhaFisica_ : nnzColunaFisica_, linhas_);
+    }
+    vector<int> nnzPorColuna() const {
+        return copiarContadores(activeIsIJ() ? nnzColunaFisica_ : nnzLinhaFisica_, colunas_);
+    }
+
+    //MULTIPLICACAO POR VETOR (SpMV): y = A*x, x com getColunas() posicoes
+    // Cada thread percorre as listas de uma faixa de linhas e escreve so as
+    // suas posicoes de y
+    vector<double> multiplicarVetor(const vector<double>& x) const {
+        vector<double> y((size_t)max(0, linhas_), 0.0);
+        bool viewIsIJ = activeIsIJ();
+        headsRowAtiva->paraCadaNaoVaziaParalelo(threadsPara((long long)tabelaIJ.size(), 1 << 15), [&](int i, Node1* cabeca, int) {
+            double soma = 0.0;
+            for (Node1* n = cabeca; n != nullptr; n = nextRowActive(n, viewIsIJ))
+                soma += n->valor * x[viewIsIJ ? n->j : n->i];
+            y[i] = soma;
+        });
+        return y;
+    }
+
+    //MULTIPLICACAO DE MATRIZES
+    // Fase simbolica separada: o padrao pode ser guardado e reaproveitado
+    // enquanto A e B so mudarem de valores (ver produto_esparso.h)
+    PadraoProduto padraoProduto(const MatrizEsparsaHashDup& B) const {
+        PadraoProduto P;
+        calcularPadrao(B, P);
+        return P;
+    }
+
+    // `poda` descarta os valores pequenos (e/ou limita cada linha) ja na fase
+    // numerica: o que sai nunca chega a ser inserido em C
+    MatrizEsparsaHashDup multiplicar(const MatrizEsparsaHashDup& B, const Poda& poda = Poda()) const {
+        PadraoProduto P;
+        calcularPadrao(B, P);
+        return multiplicarNumerico(B, P, poda);
+    }
+
+    // Recalcula `cache` so se o padrao de A ou de B mudou desde a ultima vez
+    MatrizEsparsaHashDup multiplicar(const MatrizEsparsaHashDup& B, PadraoProduto& cache, const Poda& poda = Poda()) const {
+        if (!cache.valido(versaoPadrao_, estaTransposta(), B.versaoPadrao_, B.estaTransposta()))
+            calcularPadrao(B, cache);
+        return multiplicarNumerico(B, cache, poda);
+    }
+
+    //MULTIPLICACAO MASCARADA: C = (A*B) o M, so nas posicoes de M
+    // M pode ser qualquer matriz esparsa (HashDup ou TreeDup)
+    template <typename Mascara>
+    MatrizEsparsaHashDup multiplicarMascarado(const MatrizEsparsaHashDup& B, const Mascara& M,
+                                              bool usarValores = false) const {
+        MatrizEsparsaHashDup C(linhas_, B.colunas_);
+        C.tabelaIJ.reserve(M.getNaoNulos());
+        C.tabelaJI.reserve(M.getNaoNulos());
+        produtoMascarado(*this, B, M, C, usarValores);
         return C;
     }
 
-};
+};
\ No newline at end of file
@@ -0,0 +1,340 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include "estrutura_um.h"
+#include "csr.h"
+#include "visao.h"
+#include "paralelo.h"
+#include "uso_memoria.h"
+using namespace std;
+
+/*
+    -------------
+    [HASH FRAGMENTADA POR LINHAS]
+    -------------
+    A HashDup faz cada set em tabelas e listas compartilhadas, entao a
+    construcao e a soma sao sequenciais. Aqui as linhas sao divididas em S
+    fragmentos independentes, cada um uma MatrizEsparsaHashDup completa
+    (pool, tabelas e cabecas proprios): a linha i fica no fragmento i % S,
+    como linha local i / S (intercalado, para as linhas pesadas de cargas
+    em banda ou em bloco nao cairem todas no mesmo fragmento).
+    Construcao em bloco e soma rodam uma thread por fragmento, sem trava:
+    cada thread so escreve no seu. S = numThreads() quando nao informado.
+    Cada fragmento tem ~linhas/S linhas mas todas as colunas: os indices das
+    colunas dele tem modo proprio (colunasProprias da HashDup), hiperesparsos
+    enquanto o fragmento tem poucos nao-nulos, para que a memoria nao cresca
+    como O(S*dimensao).
+    Logicamente e uma matriz so (set/getElemento/percorrer/paraCSR com os
+    indices globais). Nao tem o transpor() O(1) da HashDup -- a particao e
+    por linha --, a transposta e explicita.
+*/
+
+class MatrizEsparsaHashFragmentada {
+private:
+    int linhas_, colunas_;
+    vector<MatrizEsparsaHashDup> frag_;
+
+    int S() const { return (int)frag_.size(); }
+    static int linhasDoFragmento(int linhas, int S, int s) {
+        return linhas > s ? (linhas - s + S - 1) / S : 0;
+    }
+
+    MatrizEsparsaHashFragmentada() : linhas_(0), colunas_(0) {}
+
+    void criarFragmentos(int fragmentos, long long nnzEsperado) {
+        int S = fragmentos > 0 ? fragmentos : numThreads();
+        frag_.clear();
+        frag_.reserve(S);
+        for (int s = 0; s < S; ++s)
+            frag_.emplace_back(linhasDoFragmento(linhas_, S, s), colunas_, nnzEsperado / S, true);
+    }
+
+    // Toma os fragmentos de `o` e deixa `o` como uma matriz 0x0 valida
+    // (um fragmento vazio, para i % S() continuar definido)
+    void moverDe(MatrizEsparsaHashFragmentada& o) {
+        linhas_ = o.linhas_;
+        colunas_ = o.colunas_;
+        frag_ = std::move(o.frag_);
+        o.linhas_ = o.colunas_ = 0;
+        o.frag_.clear();
+        o.frag_.emplace_back(0, 0);
+    }
+
+public:
+    //construtor
+    MatrizEsparsaHashFragmentada(int linhas, int colunas, int fragmentos = 0)
+        : linhas_(linhas), colunas_(colunas)
+    {
+        criarFragmentos(fragmentos, 0);
+    }
+
+    // Em bloco a partir de uma CSR: cada fragmento separa as suas linhas numa
+    // CSR local e usa a construcao em bloco da HashDup, todos em paralelo
+    explicit MatrizEsparsaHashFragmentada(const MatrizCSR& M, int fragmentos = 0)
+        : linhas_(M.getLinhas()), colunas_(M.getColunas())
+    {
+        int S = fragmentos > 0 ? fragmentos : numThreads();
+        frag_.reserve(S);
+        for (int s = 0; s < S; ++s) frag_.emplace_back(0, 0);
+        const vector<long long>& ini = M.inicio();
+        const vector<int>& cols = M.colunasIdx();
+        const vector<double>& vals = M.valores();
+        paraleloPara(S, S, [&](long long a, long long b, int) {
+            for (int s = (int)a; s < (int)b; ++s) {
+                int Ls = linhasDoFragmento(linhas_, S, s);
+                vector<long long> inicio((size_t)Ls + 1, 0);
+                for (int l = 0; l < Ls; ++l) {
+                    int i = l * S + s;
+                    inicio[l + 1] = inicio[l] + (ini[i + 1] - ini[i]);
+                }
+                vector<int> c((size_t)inicio[Ls]);
+                vector<double> v((size_t)inicio[Ls]);
+                for (int l = 0; l < Ls; ++l) {
+                    int i = l * S + s;
+                    copy(cols.begin() + ini[i], cols.begin() + ini[i + 1], c.begin() + inicio[l]);
+                    copy(vals.begin() + ini[i], vals.begin() + ini[i + 1], v.begin() + inicio[l]);
+                }
+                frag_[s] = MatrizEsparsaHashDup(MatrizCSR(Ls, colunas_, std::move(inicio), std::move(c), std::move(v)), true);
+            }
+        });
+    }
+
+    // Qualquer outro formato com paraCSR() (HashDup, TreeDup, densa)
+    template <typename Matriz, typename = decltype(declval<const Matriz&>().paraCSR())>
+    explicit MatrizEsparsaHashFragmentada(const Matriz& M, int fragmentos = 0)
+        : MatrizEsparsaHashFragmentada(M.paraCSR(), fragmentos) {}
+
+    // como a HashDup: sem copias implicitas, use clonar()
+    MatrizEsparsaHashFragmentada(const MatrizEsparsaHashFragmentada&) = delete;
+    MatrizEsparsaHashFragmentada& operator=(const MatrizEsparsaHashFragmentada&) = delete;
+    MatrizEsparsaHashFragmentada(MatrizEsparsaHashFragmentada&& o) : linhas_(0), colunas_(0) {
+        moverDe(o);
+    }
+    MatrizEsparsaHashFragmentada& operator=(MatrizEsparsaHashFragmentada&& o) {
+        if (this != &o) moverDe(o);
+        return *this;
+    }
+
+    //CLONAR (um fragmento por thread)
+    MatrizEsparsaHashFragmentada clonar() const {
+        MatrizEsparsaHashFragmentada C;
+        C.linhas_ = linhas_;
+        C.colunas_ = colunas_;
+        C.frag_.reserve(S());
+        for (int s = 0; s < S(); ++s) C.frag_.emplace_back(0, 0);
+        paraleloPara(S(), S(), [&](long long a, long long b, int) {
+            for (long long s = a; s < b; ++s) C.frag_[s] = frag_[s].clonar();
+        });
+        return C;
+    }
+
+    int getLinhas() const { return linhas_; }
+    int getColunas() const { return colunas_; }
+    size_t getNaoNulos() const {
+        size_t n = 0;
+        for (auto const& F : frag_) n += F.getNaoNulos();
+        return n;
+    }
+
+    int fragmentos() const { return S(); }
+    const MatrizEsparsaHashDup& fragmento(int s) const { return frag_[s]; }
+    int fragmentoDaLinha(int i) const { return i % S(); }
+
+    //INSERIR / CONSULTAR (vao direto para o fragmento da linha)
+    // Posicao fora da matriz e ignorada, como nas outras classes (o
+    // fragmento nao confere as colunas)
+    bool dentro(int i, int j) const { return i >= 0 && j >= 0 && i < linhas_ && j < colunas_; }
+
+    void set(int i, int j, double valor) {
+        if (!dentro(i, j)) return;
+        frag_[i % S()].set(i / S(), j, valor);
+    }
+
+    double getElemento(int i, int j) const {
+        if (!dentro(i, j)) return 0.0;
+        return frag_[i % S()].getElemento(i / S(), j);
+    }
+
+    //CONSTRUCAO EM PARALELO
+    // Entradas com .i, .j e .valor (Entry do gerador). Tres passadas: conta
+    // por fragmento em cada pedaco da entrada, espalha os indices para os
+    // baldes dos fragmentos e insere cada balde com uma thread por fragmento.
+    // Dentro de um fragmento a ordem da entrada e mantida, entao posicoes
+    // repetidas ficam com o ultimo valor, como no set em sequencia; entradas
+    // fora da matriz sao ignoradas, como no set. Cada fragmento insere em
+    // lote (setEmLote): um carimbo de versao no fim em vez de um por insercao
+    // no contador global, que as S threads disputariam.
+    template <typename E>
+    void inserirEmParalelo(const vector<E>& entradas) {
+        long long n = (long long)entradas.size();
+        int S = this->S();
+        int threads = threadsPara(n, 1 << 15);
+        auto valida = [&](const E& e) { return dentro(e.i, e.j); };
+
+        vector<vector<long long>> conta(threads, vector<long long>(S, 0));
+        paraleloPara(n, threads, [&](long long ini, long long fim, int t) {
+            for (long long p = ini; p < fim; ++p)
+                if (valida(entradas[p])) ++conta[t][entradas[p].i % S];
+        });
+        // posicao de cada (pedaco, fragmento): fragmento por fragmento, pedacos em ordem
+        vector<long long> inicio((size_t)S + 1, 0);
+        for (int s = 0; s < S; ++s) {
+            long long base = inicio[s];
+            for (int t = 0; t < threads; ++t) {
+                long long c = conta[t][s];
+                conta[t][s] = base;
+                base += c;
+            }
+            inicio[s + 1] = base;
+        }
+        vector<long long> ordem((size_t)inicio[S]);
+        paraleloPara(n, threads, [&](long long ini, long long fim, int t) {
+            vector<long long>& pos = conta[t];
+            for (long long p = ini; p < fim; ++p)
+                if (valida(entradas[p])) ordem[pos[entradas[p].i % S]++] = p;
+        });
+
+        paraleloPara(S, S, [&](long long a, long long b, int) {
+            for (int s = (int)a; s < (int)b; ++s)
+                frag_[s].setEmLote([&](auto inserir) {
+                    for (long long r = inicio[s]; r < inicio[s + 1]; ++r) {
+                        const E& e = entradas[ordem[r]];
+                        inserir(e.i / S, e.j, e.valor);
+                    }
+                });
+        });
+    }
+
+    //PERCORRER ELEMENTOS (indices globais)
+    int nnzNaLinha(int i) const {
+        if (i < 0 || i >= linhas_) return 0;
+        return frag_[i % S()].nnzNaLinha(i / S());
+    }
+
+    // f(j, valor) para cada nao-nulo da linha i
+    template <typename F>
+    void paraCadaNaLinha(int i, F f) const {
+        if (i < 0 || i >= linhas_) return;
+        frag_[i % S()].paraCadaNaLinha(i / S(), f);
+    }
+
+    // f(i) para cada linha com pelo menos um nao-nulo, em ordem crescente
+    template <typename F>
+    void paraCadaLinhaNaoVazia(F f) const {
+        vector<int> linhas;
+        for (int s = 0; s < S(); ++s)
+            frag_[s].paraCadaLinhaNaoVazia([&](int l) { linhas.push_back(l * S() + s); });
+        sort(linhas.begin(), linhas.end());
+        for (int i : linhas) f(i);
+    }
+
+    // f(i, j, valor) para todos os nao-nulos, agrupados por linha
+    template <typename F>
+    void paraCadaElemento(F f) const {
+        paraCadaLinhaNaoVazia([&](int i) {
+            paraCadaNaLinha(i, [&](int j, double v) { f(i, j, v); });
+        });
+    }
+
+    //CONVERSAO PARA CSR
+    // Tamanhos das linhas por fragmento, soma prefixa global e cada fragmento
+    // escreve (ordenadas) as suas linhas nas posicoes finais, em paralelo
+    MatrizCSR paraCSR() const {
+        int S = this->S();
+        vector<long long> inicio((size_t)max(0, linhas_) + 1, 0);
+        paraleloPara(S, S, [&](long long a, long long b, int) {
+            for (int s = (int)a; s < (int)b; ++s)
+                frag_[s].paraCadaLinhaNaoVazia([&](int l) { inicio[(size_t)l * S + s + 1] = frag_[s].nnzNaLinha(l); });
+        });
+        for (int i = 0; i < linhas_; ++i) inicio[i + 1] += inicio[i];
+        vector<int> cols((size_t)inicio[linhas_]);
+        vector<double> vals((size_t)inicio[linhas_]);
+        paraleloPara(S, S, [&](long long a, long long b, int) {
+            vector<pair<int, double>> linha;
+            for (int s = (int)a; s < (int)b; ++s) {
+                frag_[s].paraCadaLinhaNaoVazia([&](int l) {
+                    linha.clear();
+                    frag_[s].paraCadaNaLinha(l, [&](int j, double v) { linha.push_back(make_pair(j, v)); });
+                    sort(linha.begin(), linha.end());
+                    long long p = inicio[(size_t)l * S + s];
+                    for (auto const& e : linha) { cols[p] = e.first; vals[p] = e.second; ++p; }
+                });
+            }
+        });
+        return MatrizCSR(linhas_, colunas_, std::move(inicio), std::move(cols), std::move(vals));
+    }
+
+    MatrizEsparsaHashFragmentada transpostaExplicita() const {
+        return MatrizEsparsaHashFragmentada(paraCSR().transposta(), S());
+    }
+
+    //SOMA DE MATRIZES
+    // Com a mesma divisao (mesmo S e mesmas dimensoes) os fragmentos somam
+    // dois a dois pela intercalacao de linhas da HashDup (somar com Poda),
+    // uma thread por fragmento; senao passa pela CSR
+    MatrizEsparsaHashFragmentada somar(const MatrizEsparsaHashFragmentada& B) const {
+        if (B.S() != S() || B.linhas_ != linhas_ || B.colunas_ != colunas_)
+            return MatrizEsparsaHashFragmentada(paraCSR().somar(B.paraCSR()), S());
+        MatrizEsparsaHashFragmentada C;
+        C.linhas_ = linhas_;
+        C.colunas_ = colunas_;
+        C.frag_.reserve(S());
+        for (int s = 0; s < S(); ++s) C.frag_.emplace_back(0, 0);
+        paraleloPara(S(), S(), [&](long long a, long long b, int) {
+            for (long long s = a; s < b; ++s) C.frag_[s] = frag_[s].somar(B.frag_[s], Poda());
+        });
+        return C;
+    }
+
+    //MULTIPLICACAO POR ESCALAR (em place, um fragmento por thread)
+    void multiplicarEscalar(double escalar) {
+        paraleloPara(S(), S(), [&](long long a, long long b, int) {
+            for (long long s = a; s < b; ++s) frag_[s].multiplicarEscalar(escalar);
+        });
+    }
+
+    //MULTIPLICACAO POR VETOR (SpMV): cada thread escreve as linhas do seu fragmento
+    vector<double> multiplicarVetor(const vector<double>& x) const {
+        vector<double> y((size_t)max(0, linhas_), 0.0);
+        int S = this->S();
+        paraleloPara(S, S, [&](long long a, long long b, int) {
+            for (int s = (int)a; s < (int)b; ++s)
+                frag_[s].paraCadaLinhaNaoVazia([&](int l) {
+                    double soma = 0.0;
+                    frag_[s].paraCadaNaLinha(l, [&](int j, double v) { soma += v * x[j]; });
+                    y[(size_t)l * S + s] = soma;
+                });
+        });
+        return y;
+    }
+
+    //MULTIPLICACAO DE MATRIZES
+    // Gustavson por linhas de A (visao.h) direto sobre os fragmentos e C
+    // separada de novo em bloco, com o mesmo S de A
+    template <typename MB>
+    MatrizEsparsaHashFragmentada multiplicar(const MB& B) const {
+        return MatrizEsparsaHashFragmentada(multiplicarPorLinhas(*this, B), S());
+    }
+
+    //USO DE MEMORIA: soma dos fragmentos
+    UsoMemoria usoMemoria() const {
+        UsoMemoria u;
+        for (auto const& F : frag_) {
+            UsoMemoria f = F.usoMemoria();
+            u.nos += f.nos;
+            u.nosVivos += f.nosVivos;
+            u.nosLivres += f.nosLivres;
+            u.tabelas += f.tabelas;
+            u.baldesIJ += f.baldesIJ;
+            u.baldesJI += f.baldesJI;
+            u.cabecas += f.cabecas;
+            u.valores += f.valores;
+            u.objeto += f.objeto;
+        }
+        u.fatorCargaIJ = u.baldesIJ ? (double)u.nosVivos / (double)u.baldesIJ : 0.0;
+        u.fatorCargaJI = u.baldesJI ? (double)u.nosVivos / (double)u.baldesJI : 0.0;
+        u.objeto += sizeof(*this);
+        return u;
+    }
+};
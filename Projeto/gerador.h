@@ -1,8 +1,12 @@
+#pragma once
 #include <iostream>
-#include <unordered_map>
-#include <cstdlib>
-#include <ctime>
+#include <vector>
+#include <string>
+#include <cstdint>
 #include <cmath>
+#include <algorithm>
+#include "paralelo.h"
+#include "csr.h"
 
 using namespace std;
 
@@ -14,48 +18,385 @@ struct Entry {
     int i, j, valor;
 };
 
-// Gera um hashmap em que a chave eh a linearizacao da posicao do elemento na matriz
-// O valor eh a propria posicao (i, j) + valor
-// Essa estrutura priorizou legibilidade em detrimento de performance,
-// porque o espaco e o tempo de construcao dessa estrutura eh desconsiderada nos testes
-unordered_map<long long, Entry>
-gerar_matriz_esparsa(long long dimensao, double esparsidade)
-{
-    unordered_map<long long, Entry> matriz;
+/*
+    Gerador baseado em contador (estilo splitmix64): o c-esimo numero da
+    sequencia de uma semente e uma funcao pura de (semente, c). Assim cada
+    thread gera a sua faixa de contadores sem estado compartilhado e a saida
+    e a mesma para qualquer numero de threads.
+*/
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
 
-    long long total = dimensao * dimensao;
-    long long num_elementos = llround(total * esparsidade);
+inline uint64_t aleatorioContador(uint64_t semente, uint64_t contador) {
+    return splitmix64(splitmix64(semente) ^ (contador * 0xD1B54A32D192ED03ULL));
+}
 
-    if (num_elementos == 0) return matriz;
+// numero em [0, n) sem o vies do `% n` (multiplicacao de 128 bits)
+inline uint64_t reduzirIntervalo(uint64_t x, uint64_t n) {
+    return (uint64_t)(((unsigned __int128)x * n) >> 64);
+}
 
-    for (long long k = 0; k < num_elementos; k++) {
-        bool posicao_valida = false;
+// Sementes dos testes: uma semente base fixa (reprodutivel) e uma sequencia
+// deterministica de sementes derivadas para as varias matrizes de um teste
+inline uint64_t& sementeBase() {
+    static uint64_t s = 458;
+    return s;
+}
 
-        while (posicao_valida == false) {
-            long long linha  = rand() % dimensao;
-            long long coluna = rand() % dimensao;
+inline uint64_t& contadorSementes() {
+    static uint64_t c = 0;
+    return c;
+}
 
-            long long chave = gerarChave(linha, coluna, dimensao);
+void definir_semente(uint64_t semente) {
+    sementeBase() = semente;
+    contadorSementes() = 0;
+}
 
-            // Verifica se a chave ja foi usada, ou seja, se a posicao ja foi preenchida
-            if (matriz.find(chave) == matriz.end()) {
-                posicao_valida = true;
-                int valor = (rand() % 100) + 1;
+uint64_t proxima_semente() {
+    return splitmix64(sementeBase() ^ splitmix64(++contadorSementes()));
+}
 
-                Entry e;
-                e.i = linha;
-                e.j = coluna;
-                e.valor = valor;
-                matriz[chave] = e;
+// Nucleo comum dos geradores: k chaves distintas (i*colunas + j) em ordem.
+// amostrar(semente, c, chave) sorteia o candidato do contador c e devolve
+// false se ele cair fora do padrao (ex.: fora da banda).
+// As posicoes escolhidas sao, por definicao, as k primeiras chaves distintas
+// da sequencia de contadores da semente: candidatos sao gerados em paralelo,
+// ordenados, e as repeticoes descartadas ficando com o menor contador. Se
+// faltarem chaves, mais contadores sao gerados. Nada disso passa por hash.
+// k precisa ser no maximo o numero de posicoes que o amostrador alcanca.
+// Distribuicoes muito concentradas (Zipf, R-MAT) quase nunca sorteiam as
+// ultimas posicoes livres quando k chega perto da capacidade; se menos de
+// 1/256 de um lote virar chave nova, os contadores seguintes passam a usar
+// `reserva` (ex.: uniforme no padrao inteiro) para completar.
+template <typename Amostrador, typename Reserva>
+vector<uint64_t> gerar_chaves_distintas(long long k, uint64_t semente, int threads,
+                                        Amostrador amostrar, Reserva reserva)
+{
+    const uint64_t INVALIDA = UINT64_MAX;
+    struct Candidato { uint64_t chave, contador; };
+    auto porChave = [](const Candidato& a, const Candidato& b) {
+        return a.chave != b.chave ? a.chave < b.chave : a.contador < b.contador;
+    };
+
+    vector<Candidato> distintos;   // chaves distintas com o menor contador de cada uma
+    uint64_t proximo = 0;
+    double aproveitamento = 1.0;   // fracao do ultimo lote que virou chave nova
+    bool usarReserva = false;
+    while ((long long)distintos.size() < k) {
+        long long faltam = k - (long long)distintos.size();
+        // com rejeicao ou padrao quase cheio poucas amostras rendem chave nova:
+        // o lote cresce na mesma proporcao para nao ordenar tudo a cada punhado
+        double escala = 1.0 / max(aproveitamento, 1.0 / 256);
+        long long lote = (long long)min((double)(1 << 24), (faltam + faltam / 8) * escala) + 64;
+
+        size_t base = distintos.size();
+        distintos.resize(base + (size_t)lote);
+        paraleloPara(lote, threads, [&](long long ini, long long fim, int) {
+            for (long long c = ini; c < fim; ++c) {
+                uint64_t cont = proximo + (uint64_t)c;
+                uint64_t chave;
+                bool ok = usarReserva ? reserva(semente, cont, chave) : amostrar(semente, cont, chave);
+                if (!ok) chave = INVALIDA;
+                distintos[base + c] = Candidato{chave, cont};
             }
+        });
+        proximo += (uint64_t)lote;
+
+        ordenarParalelo(distintos, porChave, threads);
+        size_t w = 0;
+        for (size_t r = 0; r < distintos.size(); ++r) {
+            if (distintos[r].chave == INVALIDA) break;   // invalidas ficam no fim
+            if (w == 0 || distintos[r].chave != distintos[w - 1].chave) distintos[w++] = distintos[r];
+        }
+        aproveitamento = (double)(w - base) / (double)lote;
+        if (aproveitamento < 1.0 / 256) usarReserva = true;
+        distintos.resize(w);
+    }
+
+    // sobrou mais do que k: ficam as chaves que apareceram primeiro na sequencia
+    if ((long long)distintos.size() > k) {
+        auto porContador = [](const Candidato& a, const Candidato& b) { return a.contador < b.contador; };
+        nth_element(distintos.begin(), distintos.begin() + k, distintos.end(), porContador);
+        distintos.resize((size_t)k);
+        ordenarParalelo(distintos, porChave, threads);
+    }
+
+    vector<uint64_t> chaves(distintos.size());
+    for (size_t p = 0; p < distintos.size(); ++p) chaves[p] = distintos[p].chave;
+    return chaves;
+}
+
+template <typename Amostrador>
+vector<uint64_t> gerar_chaves_distintas(long long k, uint64_t semente, int threads, Amostrador amostrar) {
+    return gerar_chaves_distintas(k, semente, threads, amostrar, amostrar);
+}
+
+// Converte chaves ordenadas em COO, com valores inteiros em [1, 100].
+// O valor depende so da posicao, entao tambem nao depende das threads.
+vector<Entry> chaves_para_coo(const vector<uint64_t>& chaves, long long colunas, uint64_t semente, int threads)
+{
+    uint64_t sementeValores = splitmix64(semente ^ 0x5851F42D4C957F2DULL);
+    vector<Entry> saida(chaves.size());
+    paraleloPara((long long)chaves.size(), threads, [&](long long ini, long long fim, int) {
+        for (long long p = ini; p < fim; ++p) {
+            uint64_t c = chaves[p];
+            saida[p].i = (int)(c / (uint64_t)colunas);
+            saida[p].j = (int)(c % (uint64_t)colunas);
+            saida[p].valor = (int)(aleatorioContador(sementeValores, c) % 100) + 1;
+        }
+    });
+    return saida;
+}
+
+// Gera exatamente k posicoes distintas, uniformes, de uma matriz linhas x
+// colunas, em COO ordenado por (i, j).
+vector<Entry> gerar_coo_esparsa(long long linhas, long long colunas, long long k,
+                                uint64_t semente, int threads = 0)
+{
+    long long total = linhas * colunas;
+    k = max(0LL, min(k, total));
+    if (k == 0) return vector<Entry>();
+    if (threads <= 0) threads = threadsPara(k, 1 << 15);
+
+    // quando quase todas as posicoes entram e mais barato sortear as que ficam de fora
+    bool complemento = (2 * k > total);
+    auto uniforme = [total](uint64_t sem, uint64_t c, uint64_t& chave) {
+        chave = reduzirIntervalo(aleatorioContador(sem, c), (uint64_t)total);
+        return true;
+    };
+    vector<uint64_t> chaves = gerar_chaves_distintas(complemento ? total - k : k, semente, threads, uniforme);
+
+    if (complemento) {
+        vector<uint64_t> fora;
+        fora.swap(chaves);
+        chaves.reserve((size_t)k);
+        size_t p = 0;
+        for (long long c = 0; c < total; ++c) {
+            if (p < fora.size() && fora[p] == (uint64_t)c) { ++p; continue; }
+            chaves.push_back((uint64_t)c);
+        }
+    }
+    return chaves_para_coo(chaves, colunas, semente, threads);
+}
+
+// Mesma geracao, mas ja montada numa CSR (as entradas saem ordenadas por linha)
+MatrizCSR gerar_csr_esparsa(long long linhas, long long colunas, long long k,
+                            uint64_t semente, int threads = 0)
+{
+    vector<Entry> coo = gerar_coo_esparsa(linhas, colunas, k, semente, threads);
+    vector<long long> inicio((size_t)linhas + 1, 0);
+    vector<int> cols(coo.size());
+    vector<double> vals(coo.size());
+    for (size_t p = 0; p < coo.size(); ++p) {
+        ++inicio[coo[p].i + 1];
+        cols[p] = coo[p].j;
+        vals[p] = coo[p].valor;
+    }
+    for (long long i = 0; i < linhas; ++i) inicio[i + 1] += inicio[i];
+    return MatrizCSR((int)linhas, (int)colunas, std::move(inicio), std::move(cols), std::move(vals));
+}
+
+// Fisher-Yates com a sequencia de contadores da semente (reprodutivel)
+void embaralhar_entradas(vector<Entry>& v, uint64_t semente) {
+    for (size_t p = v.size(); p > 1; --p) {
+        size_t q = (size_t)reduzirIntervalo(aleatorioContador(semente, p), p);
+        swap(v[p - 1], v[q]);
+    }
+}
+
+/*
+    -------------
+    [CARGAS ESTRUTURADAS]
+    -------------
+    Matrizes reais nao sao uniformes: linhas com grau em lei de potencia
+    (uma linha "quente" deixa a lista encadeada da Estrutura 1 enorme),
+    estenceis em banda, blocos na diagonal, grafos tipo R-MAT. Todas usam o
+    mesmo nucleo de gerar_chaves_distintas (exatamente k posicoes distintas,
+    mesma saida para qualquer numero de threads).
+*/
+enum class TipoCarga { UNIFORME, BANDA, BLOCO_DIAGONAL, ZIPF, RMAT };
+
+struct ParametrosCarga {
+    long long banda = 8;              // BANDA: |i - j| <= banda
+    long long tamanhoBloco = 64;      // BLOCO_DIAGONAL
+    double expoenteZipf = 1.2;        // ZIPF: P(linha de posto r) ~ 1 / r^s
+    double rmat[3] = {0.57, 0.19, 0.19};   // R-MAT: a, b, c (d = 1 - a - b - c)
+};
+
+const char* nomeCarga(TipoCarga t) {
+    switch (t) {
+        case TipoCarga::UNIFORME: return "uniforme";
+        case TipoCarga::BANDA: return "banda";
+        case TipoCarga::BLOCO_DIAGONAL: return "bloco_diagonal";
+        case TipoCarga::ZIPF: return "zipf";
+        case TipoCarga::RMAT: return "rmat";
+    }
+    return "?";
+}
+
+const vector<TipoCarga>& todasCargas() {
+    static const vector<TipoCarga> v = {TipoCarga::UNIFORME, TipoCarga::BANDA,
+        TipoCarga::BLOCO_DIAGONAL, TipoCarga::ZIPF, TipoCarga::RMAT};
+    return v;
+}
+
+bool cargaPorNome(const string& nome, TipoCarga& t) {
+    for (TipoCarga c : todasCargas())
+        if (nome == nomeCarga(c)) { t = c; return true; }
+    return false;
+}
+
+// Numero de posicoes que a carga consegue gerar numa matriz dimensao x dimensao
+long long capacidadeCarga(TipoCarga t, long long n, const ParametrosCarga& p) {
+    switch (t) {
+        case TipoCarga::BANDA: {
+            long long b = min(p.banda, n - 1);
+            return n * (2 * b + 1) - b * (b + 1);
         }
+        case TipoCarga::BLOCO_DIAGONAL: {
+            long long s = max(1LL, min(p.tamanhoBloco, n));
+            long long resto = n % s;
+            return (n / s) * s * s + resto * resto;
+        }
+        default:
+            return n * n;
+    }
+}
+
+// numero uniforme em [0, 1)
+inline double uniforme01(uint64_t x) {
+    return (double)(x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+vector<Entry> gerar_coo_carga(TipoCarga tipo, long long n, long long k, uint64_t semente,
+                              const ParametrosCarga& p = ParametrosCarga(), int threads = 0)
+{
+    if (tipo == TipoCarga::UNIFORME) return gerar_coo_esparsa(n, n, k, semente, threads);
+
+    k = max(0LL, min(k, capacidadeCarga(tipo, n, p)));
+    if (k == 0) return vector<Entry>();
+    if (threads <= 0) threads = threadsPara(k, 1 << 15);
+    const uint64_t N = (uint64_t)n;
+    vector<uint64_t> chaves;
+
+    // Zipf e R-MAT: perto da capacidade o resto e completado com posicoes uniformes
+    auto uniforme = [N](uint64_t sem, uint64_t c, uint64_t& chave) {
+        chave = reduzirIntervalo(aleatorioContador(sem, c), N * N);
+        return true;
+    };
+
+    if (tipo == TipoCarga::BANDA) {
+        long long b = min(p.banda, n - 1);
+        chaves = gerar_chaves_distintas(k, semente, threads, [=](uint64_t sem, uint64_t c, uint64_t& chave) {
+            long long i = (long long)reduzirIntervalo(aleatorioContador(sem, 2 * c), N);
+            long long j = i - b + (long long)reduzirIntervalo(aleatorioContador(sem, 2 * c + 1), (uint64_t)(2 * b + 1));
+            if (j < 0 || j >= n) return false;
+            chave = (uint64_t)i * N + (uint64_t)j;
+            return true;
+        });
+    } else if (tipo == TipoCarga::BLOCO_DIAGONAL) {
+        long long s = max(1LL, min(p.tamanhoBloco, n));
+        uint64_t blocos = (uint64_t)((n + s - 1) / s);
+        chaves = gerar_chaves_distintas(k, semente, threads, [=](uint64_t sem, uint64_t c, uint64_t& chave) {
+            long long inicio = (long long)reduzirIntervalo(aleatorioContador(sem, 3 * c), blocos) * s;
+            long long i = inicio + (long long)reduzirIntervalo(aleatorioContador(sem, 3 * c + 1), (uint64_t)s);
+            long long j = inicio + (long long)reduzirIntervalo(aleatorioContador(sem, 3 * c + 2), (uint64_t)s);
+            if (i >= n || j >= n) return false;   // ultimo bloco incompleto
+            chave = (uint64_t)i * N + (uint64_t)j;
+            return true;
+        });
+    } else if (tipo == TipoCarga::ZIPF) {
+        // posto r em [1, n] pela inversa da distribuicao continua ~ 1/r^s;
+        // a linha r-1 e a r-esima mais pesada (a linha 0 e a "quente")
+        double s = p.expoenteZipf;
+        chaves = gerar_chaves_distintas(k, semente, threads, [=](uint64_t sem, uint64_t c, uint64_t& chave) {
+            double u = uniforme01(aleatorioContador(sem, 2 * c));
+            double r = (fabs(s - 1.0) < 1e-9) ? pow((double)n + 1.0, u)
+                     : pow(1.0 + u * (pow((double)n + 1.0, 1.0 - s) - 1.0), 1.0 / (1.0 - s));
+            long long i = min(n - 1, max(0LL, (long long)r - 1));
+            uint64_t j = reduzirIntervalo(aleatorioContador(sem, 2 * c + 1), N);
+            chave = (uint64_t)i * N + j;
+            return true;
+        }, uniforme);
+    } else {
+        // R-MAT: em cada nivel escolhe um quadrante com probabilidades a, b, c, d
+        int niveis = 0;
+        while ((1LL << niveis) < n) ++niveis;
+        double a = p.rmat[0], ab = a + p.rmat[1], abc = ab + p.rmat[2];
+        chaves = gerar_chaves_distintas(k, semente, threads, [=](uint64_t sem, uint64_t c, uint64_t& chave) {
+            uint64_t i = 0, j = 0;
+            for (int nv = 0; nv < niveis; ++nv) {
+                double u = uniforme01(aleatorioContador(sem, c * 64 + (uint64_t)nv));
+                i <<= 1; j <<= 1;
+                if (u >= abc) { i |= 1; j |= 1; }
+                else if (u >= ab) i |= 1;
+                else if (u >= a) j |= 1;
+            }
+            if (i >= N || j >= N) return false;
+            chave = i * N + j;
+            return true;
+        }, uniforme);
     }
+    return chaves_para_coo(chaves, n, semente, threads);
+}
+
+// Carga usada por gerar_matriz_esparsa (os testes percorrem as cargas pedidas)
+TipoCarga& cargaAtual() {
+    static TipoCarga t = TipoCarga::UNIFORME;
+    return t;
+}
+
+ParametrosCarga& parametrosCarga() {
+    static ParametrosCarga p;
+    return p;
+}
 
-    return matriz;
+// Cargas pedidas na linha de comando dos testes ("todas" = todas);
+// sem argumentos fica so a uniforme, como nos resultados historicos
+vector<TipoCarga> cargasDaLinhaDeComando(int argc, char** argv) {
+    vector<TipoCarga> cargas;
+    for (int a = 1; a < argc; ++a) {
+        string nome = argv[a];
+        TipoCarga t;
+        if (nome == "todas") return todasCargas();
+        if (cargaPorNome(nome, t)) cargas.push_back(t);
+        else cerr << "carga desconhecida: " << nome << endl;
+    }
+    if (cargas.empty()) cargas.push_back(TipoCarga::UNIFORME);
+    return cargas;
+}
+
+// Matriz quadrada com round(dimensao^2 * esparsidade) elementos (ou k, em
+// gerar_matriz_esparsa_k), na posicao (i, j) + valor. A semente vem da
+// sequencia de proxima_semente(), entao duas chamadas seguidas geram
+// matrizes diferentes, mas o teste inteiro se repete igual para a mesma
+// semente base.
+// As entradas sao devolvidas embaralhadas para que os testes de construcao e
+// de SET/GET continuem inserindo e consultando em ordem aleatoria (quem quer
+// a ordem por linha usa gerar_coo_esparsa / gerar_coo_carga direto).
+vector<Entry>
+gerar_matriz_esparsa_k(long long dimensao, long long num_elementos)
+{
+    uint64_t semente = proxima_semente();
+    vector<Entry> v = gerar_coo_carga(cargaAtual(), dimensao, num_elementos, semente, parametrosCarga());
+    embaralhar_entradas(v, splitmix64(semente));
+    return v;
+}
+
+vector<Entry>
+gerar_matriz_esparsa(long long dimensao, double esparsidade)
+{
+    long long total = dimensao * dimensao;
+    return gerar_matriz_esparsa_k(dimensao, llround(total * esparsidade));
 }
 
 void gerarTodasMatrizesEsparsas() {
-    srand(time(NULL));
+    definir_semente(458);
 
     for (int i = 1; i <= 3; i++) {
         double esparsidades[4];
@@ -0,0 +1,195 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "paralelo.h"
+#include "uso_memoria.h"
+using namespace std;
+
+/*
+    -------------
+    [INDICE POR LINHA/COLUNA: VETOR OU HIPERESPARSO]
+    -------------
+    Um valor por linha (ou coluna) -- cabeca de lista, contador -- guardado
+    de um de dois jeitos:
+      - denso: vector de `tamanho` posicoes (acesso direto, O(dimensao) de
+        memoria mesmo com a matriz vazia);
+      - hiperesparso (como o DCSR/DCSC): so as posicoes com valor diferente
+        de T() ficam, numa tabela hash; as nao vazias sao percorridas em
+        ordem crescente por uma lista ordenada das chaves, refeita so quando
+        alguma chave entra ou sai.
+    Com dimensao 10^8 o vetor de ponteiros sozinho tem 800 MB; hiperesparso
+    o custo e proporcional as linhas que tem alguma coisa.
+*/
+
+template <typename T>
+class IndiceCompacto {
+private:
+    long long tamanho_;
+    bool hiper_;
+    vector<T> denso_;
+    unordered_map<int, T> esparso_;
+
+    // Chaves do modo hiperesparso em ordem crescente, com o endereco do valor
+    // na tabela (enderecos de um unordered_map sobrevivem ao rehash), para
+    // percorrer sem ordenar nem buscar de novo a cada vez. Refeita sob
+    // demanda depois que uma chave entra ou sai; a trava deixa leituras const
+    // concorrentes seguras e o shared_ptr mantem viva a lista que estiver
+    // sendo percorrida mesmo que outra seja montada no meio.
+    typedef vector<pair<int, const T*>> Ordem;
+    mutable shared_ptr<const Ordem> ordem_;
+    mutable atomic<bool> ordemValida_{false};
+    mutable mutex travaOrdem_;
+
+    shared_ptr<const Ordem> ordenadas() const {
+        lock_guard<mutex> trava(travaOrdem_);
+        if (!ordemValida_.load(memory_order_relaxed)) {
+            auto nova = make_shared<Ordem>();
+            nova->reserve(esparso_.size());
+            for (auto const& p : esparso_) nova->push_back(make_pair(p.first, &p.second));
+            sort(nova->begin(), nova->end(),
+                 [](const pair<int, const T*>& a, const pair<int, const T*>& b) { return a.first < b.first; });
+            ordem_ = std::move(nova);
+            ordemValida_.store(true, memory_order_relaxed);
+        }
+        return ordem_;
+    }
+
+    void invalidarOrdem() { ordemValida_.store(false, memory_order_relaxed); }
+
+    void copiarDe(const IndiceCompacto& o) {
+        tamanho_ = o.tamanho_;
+        hiper_ = o.hiper_;
+        denso_ = o.denso_;
+        esparso_ = o.esparso_;
+        invalidarOrdem();
+    }
+    void moverDe(IndiceCompacto& o) {
+        tamanho_ = o.tamanho_;
+        hiper_ = o.hiper_;
+        denso_ = std::move(o.denso_);
+        esparso_ = std::move(o.esparso_);
+        invalidarOrdem();
+        o.esparso_.clear();
+        o.invalidarOrdem();
+    }
+
+public:
+    IndiceCompacto() : IndiceCompacto(0, false) {}
+
+    // o vetor denso tem pelo menos uma posicao (como as cabecas antigas)
+    IndiceCompacto(long long tamanho, bool hiper) : tamanho_(tamanho), hiper_(hiper) {
+        if (!hiper_) denso_.assign((size_t)max(1LL, tamanho_), T());
+    }
+
+    // copia e movimento refazem a ordem das chaves no destino
+    IndiceCompacto(const IndiceCompacto& o) { copiarDe(o); }
+    IndiceCompacto(IndiceCompacto&& o) noexcept { moverDe(o); }
+    IndiceCompacto& operator=(const IndiceCompacto& o) {
+        if (this != &o) copiarDe(o);
+        return *this;
+    }
+    IndiceCompacto& operator=(IndiceCompacto&& o) noexcept {
+        if (this != &o) moverDe(o);
+        return *this;
+    }
+
+    long long tamanho() const { return tamanho_; }
+    bool hiperesparso() const { return hiper_; }
+
+    // posicoes com valor (no modo denso conta o vetor inteiro)
+    size_t naoVazias() const {
+        if (hiper_) return esparso_.size();
+        return (size_t)count_if(denso_.begin(), denso_.end(), [](const T& v) { return v != T(); });
+    }
+
+    T operator[](long long i) const {
+        if (!hiper_) return denso_[i];
+        auto it = esparso_.find((int)i);
+        return it == esparso_.end() ? T() : it->second;
+    }
+
+    void definir(long long i, T v) {
+        if (!hiper_) { denso_[i] = v; return; }
+        if (v == T()) {
+            if (esparso_.erase((int)i)) invalidarOrdem();
+            return;
+        }
+        auto r = esparso_.emplace((int)i, v);
+        if (r.second) invalidarOrdem();
+        else r.first->second = v;
+    }
+
+    void somar(long long i, T delta) {
+        if (!hiper_) { denso_[i] += delta; return; }
+        definir(i, (*this)[i] + delta);
+    }
+
+    // f(i, valor) para as posicoes com valor, em ordem crescente
+    template <typename F>
+    void paraCadaNaoVazia(F f) const {
+        if (!hiper_) {
+            for (long long i = 0; i < (long long)denso_.size(); ++i)
+                if (denso_[i] != T()) f((int)i, denso_[i]);
+            return;
+        }
+        auto ordem = ordenadas();
+        for (auto const& [i, v] : *ordem) f(i, *v);
+    }
+
+    // f(i, valor, t) em paralelo: faixas contiguas de [0, tamanho) no modo
+    // denso, das chaves ordenadas no hiperesparso
+    template <typename F>
+    void paraCadaNaoVaziaParalelo(int threads, F f) const {
+        if (!hiper_) {
+            paraleloPara((long long)denso_.size(), threads, [&](long long ini, long long fim, int t) {
+                for (long long i = ini; i < fim; ++i)
+                    if (denso_[i] != T()) f((int)i, denso_[i], t);
+            });
+            return;
+        }
+        auto ordem = ordenadas();
+        paraleloPara((long long)ordem->size(), threads, [&](long long ini, long long fim, int t) {
+            for (long long r = ini; r < fim; ++r) f((*ordem)[r].first, *(*ordem)[r].second, t);
+        });
+    }
+
+    // valor = f(valor) nas posicoes com valor (f nao pode devolver T())
+    template <typename F>
+    void transformar(F f) {
+        if (!hiper_) {
+            for (T& v : denso_) if (v != T()) v = f(v);
+            return;
+        }
+        for (auto& p : esparso_) p.second = f(p.second);
+    }
+
+    // troca de representacao mantendo o conteudo
+    void mudarModo(bool hiper) {
+        if (hiper == hiper_) return;
+        if (hiper) {
+            esparso_.clear();
+            for (long long i = 0; i < (long long)denso_.size(); ++i)
+                if (denso_[i] != T()) esparso_.emplace((int)i, denso_[i]);
+            vector<T>().swap(denso_);
+            invalidarOrdem();
+        } else {
+            denso_.assign((size_t)max(1LL, tamanho_), T());
+            for (auto const& p : esparso_) denso_[p.first] = p.second;
+            unordered_map<int, T>().swap(esparso_);
+            lock_guard<mutex> trava(travaOrdem_);
+            ordem_.reset();
+            invalidarOrdem();
+        }
+        hiper_ = hiper;
+    }
+
+    size_t bytes() const {
+        lock_guard<mutex> trava(travaOrdem_);
+        size_t ordem = hiper_ && ordem_ ? bytesVetor(*ordem_) : 0;
+        return bytesVetor(denso_) + (hiper_ ? bytesTabelaHash(esparso_) : 0) + ordem;
+    }
+};
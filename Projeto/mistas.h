@@ -0,0 +1,138 @@
+#pragma once
+#include "densa.h"
+#include "estrutura_um.h"
+#include "estrutura_dois.h"
+#include "paralelo.h"
+#include "simd.h"
+using namespace std;
+
+/*
+    -------------
+    [OPERACOES MISTAS DENSA / ESPARSA]
+    -------------
+*/
+
+//SDDMM: C = (A*B) o M com A e B densas
+// So os produtos internos das posicoes de M sao calculados: O(nnz(M) * k)
+// em vez dos O(n*m*k) do produto denso inteiro. O tipo de C e o tipo da
+// mascara. Com usarValores=true o resultado e multiplicado pelos valores de M.
+template <typename Esparsa>
+Esparsa sddmm(const MatrizDensa& A, const MatrizDensa& B, const Esparsa& M, bool usarValores = false) {
+    const int k = A.getColunas();
+    Esparsa C(M.getLinhas(), M.getColunas());
+
+    // as colunas de B sao percorridas muitas vezes: compensa transpor B uma vez
+    // para que os dois lados do produto interno fiquem contiguos
+    bool transpor = (long long)M.getNaoNulos() > (long long)B.getColunas();
+    auto guardar = [&](int i, int j, double soma, double m) {
+        if (usarValores) soma *= m;
+        if (soma != 0.0) C.set(i, j, soma);
+    };
+    if (transpor) {
+        MatrizDensa Bt = B.transposta();
+        M.paraCadaElemento([&](int i, int j, double m) {
+            const double* a = A.linha(i);
+            const double* b = Bt.linha(j);
+            double soma = 0.0;
+            for (int p = 0; p < k; ++p) soma += a[p] * b[p];
+            guardar(i, j, soma, m);
+        });
+        return C;
+    }
+
+    // poucas posicoes: as entradas de M sao agrupadas por coluna e cada
+    // coluna j de B e copiada uma vez para um buffer contiguo
+    struct Entrada { int j, i; double m; };
+    vector<Entrada> entradas;
+    entradas.reserve(M.getNaoNulos());
+    M.paraCadaElemento([&](int i, int j, double m) { entradas.push_back({j, i, m}); });
+    sort(entradas.begin(), entradas.end(), [](const Entrada& x, const Entrada& y) {
+        return x.j != y.j ? x.j < y.j : x.i < y.i;
+    });
+    vector<double> b(k);
+    for (size_t e = 0; e < entradas.size(); ++e) {
+        const int j = entradas[e].j;
+        if (e == 0 || entradas[e - 1].j != j)
+            for (int p = 0; p < k; ++p) b[p] = B.linha(p)[j];
+        const double* a = A.linha(entradas[e].i);
+        double soma = 0.0;
+        for (int p = 0; p < k; ++p) soma += a[p] * b[p];
+        guardar(entradas[e].i, j, soma, entradas[e].m);
+    }
+    return C;
+}
+
+//SpMM: C = A*B com A esparsa e B densa (tipicamente alta e estreita)
+// Cada linha i de A e lida uma vez para um buffer e as linhas de B das
+// suas colunas sao somadas na linha i de C com axpy SIMD, em blocos de
+// BLOCO colunas: o pedaco da linha de C fica na L1 enquanto todas as
+// entradas da linha passam por ele. As linhas nao vazias de A sao divididas
+// entre as threads (cada uma escreve so as suas linhas de C).
+template <typename PercorrerLinha>
+void spmmPorLinhas(const vector<int>& linhasNaoVazias, long long nnz, PercorrerLinha percorrer,
+                   const MatrizDensa& B, MatrizDensa& C) {
+    const int BLOCO = 512;
+    const int p = B.getColunas();
+    paraleloPara((long long)linhasNaoVazias.size(), threadsPara(nnz * max(1, p), 1 << 18), [&](long long r0, long long r1, int) {
+        vector<pair<int, double>> entradas;
+        for (long long r = r0; r < r1; ++r) {
+            int i = linhasNaoVazias[r];
+            entradas.clear();
+            percorrer(i, [&](int k, double v) { entradas.push_back(make_pair(k, v)); });
+            double* c = C.linha(i);
+            for (int jb = 0; jb < p; jb += BLOCO) {
+                int largura = min(BLOCO, p - jb);
+                for (auto const& [k, v] : entradas) simdAxpy(c + jb, B.linha(k) + jb, v, largura);
+            }
+        }
+    });
+}
+
+template <typename Esparsa>
+MatrizDensa multiplicarEsparsaDensa(const Esparsa& A, const MatrizDensa& B) {
+    MatrizDensa C(A.getLinhas(), B.getColunas());
+    vector<int> linhas;
+    A.paraCadaLinhaNaoVazia([&](int i) { linhas.push_back(i); });
+    spmmPorLinhas(linhas, (long long)A.getNaoNulos(),
+                  [&](int i, auto f) { A.paraCadaNaLinha(i, f); }, B, C);
+    return C;
+}
+
+// C = A*B com A densa e B esparsa, direto por linhas de C: a linha i de C
+// e a soma, sobre os k com A(i,k) != 0, de A(i,k) vezes a linha k de B.
+// As linhas nao vazias de B sao copiadas uma vez para vetores contiguos
+// (so paraCadaLinhaNaoVazia/paraCadaNaLinha: serve para qualquer esparsa e
+// nao percorre as linhas vazias) e as linhas de A/C sao divididas entre as
+// threads. Nenhuma transposta e nenhuma copia densa alem de C.
+template <typename Esparsa>
+MatrizDensa multiplicarDensaEsparsa(const MatrizDensa& A, const Esparsa& B) {
+    MatrizDensa C(A.getLinhas(), B.getColunas());
+    const int K = min(A.getColunas(), B.getLinhas());
+    vector<int> linhasB;
+    vector<long long> inicio(1, 0);
+    vector<int> cols;
+    vector<double> vals;
+    B.paraCadaLinhaNaoVazia([&](int k) {
+        if (k >= K) return;
+        B.paraCadaNaLinha(k, [&](int j, double v) {
+            cols.push_back(j);
+            vals.push_back(v);
+        });
+        linhasB.push_back(k);
+        inicio.push_back((long long)cols.size());
+    });
+
+    long long trabalho = (long long)A.getLinhas() * (long long)max<size_t>(1, cols.size());
+    paraleloPara(A.getLinhas(), threadsPara(trabalho, 1 << 18), [&](long long i0, long long i1, int) {
+        for (long long i = i0; i < i1; ++i) {
+            const double* a = A.linha((int)i);
+            double* c = C.linha((int)i);
+            for (size_t r = 0; r < linhasB.size(); ++r) {
+                double aik = a[linhasB[r]];
+                if (aik == 0.0) continue;
+                for (long long q = inicio[r]; q < inicio[r + 1]; ++q) c[cols[q]] += aik * vals[q];
+            }
+        }
+    });
+    return C;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+using namespace std;
+
+/*
+    -------------
+    [PARALELISMO]
+    -------------
+    Laco paralelo simples com std::thread. O intervalo [0, n) e dividido em
+    pedacos contiguos, um por thread, e cada thread recebe (inicio, fim, t).
+    A divisao so depende de n e do numero de threads, entao kernels que
+    escrevem em posicoes calculadas a partir do pedaco continuam
+    deterministicos.
+*/
+
+// 0 = usar todos os nucleos da maquina
+inline atomic<int>& threadsConfiguradas() {
+    static atomic<int> n(0);
+    return n;
+}
+
+inline void definirNumThreads(int n) {
+    threadsConfiguradas() = max(0, n);
+}
+
+inline int numThreads() {
+    int n = threadsConfiguradas();
+    if (n > 0) return n;
+    int hw = (int)thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+// Numero de threads que vale a pena usar para n itens, com pelo menos
+// `minimoPorThread` itens em cada uma (criar uma thread custa dezenas de us)
+inline int threadsPara(long long n, long long minimoPorThread) {
+    long long t = n / max(1LL, minimoPorThread);
+    return (int)max(1LL, min((long long)numThreads(), t));
+}
+
+// f(inicio, fim, t) para t em [0, threads)
+template <typename F>
+void paraleloPara(long long n, int threads, F f) {
+    threads = (int)max(1LL, min((long long)threads, n));
+    if (threads <= 1) {
+        f(0LL, n, 0);
+        return;
+    }
+    vector<thread> pool;
+    pool.reserve(threads - 1);
+    for (int t = 1; t < threads; ++t) {
+        long long ini = n * t / threads, fim = n * (t + 1) / threads;
+        pool.emplace_back([=, &f]() { f(ini, fim, t); });
+    }
+    f(0LL, n / threads, 0);
+    for (auto& th : pool) th.join();
+}
+
+template <typename F>
+void paraleloPara(long long n, F f) {
+    paraleloPara(n, threadsPara(n, 4096), f);
+}
+
+// Reducao: f(inicio, fim) devolve o parcial de um pedaco e os parciais sao
+// juntados na ordem dos pedacos, entao o resultado (com ponto flutuante)
+// so depende do numero de threads
+template <typename T, typename F, typename Juntar>
+T reduzirParalelo(long long n, int threads, T neutro, F f, Juntar juntar) {
+    threads = (int)max(1LL, min((long long)threads, n));
+    vector<T> parciais(threads, neutro);
+    paraleloPara(n, threads, [&](long long ini, long long fim, int t) { parciais[t] = f(ini, fim); });
+    T total = neutro;
+    for (auto const& p : parciais) total = juntar(total, p);
+    return total;
+}
+
+// Ordena v em paralelo: cada thread ordena um pedaco e os pedacos sao
+// intercalados dois a dois (tambem em paralelo). Com uma comparacao total
+// o resultado nao depende do numero de threads.
+template <typename T, typename Cmp>
+void ordenarParalelo(vector<T>& v, Cmp cmp, int threads = 0) {
+    long long n = (long long)v.size();
+    if (threads <= 0) threads = threadsPara(n, 1 << 15);
+    threads = (int)max(1LL, min((long long)threads, n));
+    if (threads <= 1) {
+        sort(v.begin(), v.end(), cmp);
+        return;
+    }
+
+    vector<long long> cortes(threads + 1);
+    for (int t = 0; t <= threads; ++t) cortes[t] = n * t / threads;
+    paraleloPara(threads, threads, [&](long long t0, long long t1, int) {
+        for (long long t = t0; t < t1; ++t) sort(v.begin() + cortes[t], v.begin() + cortes[t + 1], cmp);
+    });
+
+    // intercala pedacos vizinhos ate sobrar um so
+    while (cortes.size() > 2) {
+        long long pares = (long long)(cortes.size() - 1) / 2;
+        paraleloPara(pares, (int)pares, [&](long long p0, long long p1, int) {
+            for (long long p = p0; p < p1; ++p)
+                inplace_merge(v.begin() + cortes[2 * p], v.begin() + cortes[2 * p + 1],
+                              v.begin() + cortes[2 * p + 2], cmp);
+        });
+        vector<long long> novos;
+        for (size_t c = 0; c < cortes.size(); c += 2) novos.push_back(cortes[c]);
+        if (novos.back() != n) novos.push_back(n);
+        cortes.swap(novos);
+    }
+}
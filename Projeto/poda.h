@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+using namespace std;
+
+/*
+    -------------
+    [PODA POR TOLERANCIA]
+    -------------
+    Criterio para descartar valores pequenos no resultado de somar e
+    multiplicar (em vez de guardar e depois remover com set(i, j, 0.0) no a
+    no) e para o podar() avulso das matrizes esparsas:
+      - tolerancia: sai todo valor com |v| <= tolerancia (0 = so os zeros
+        exatos, que e o que as operacoes ja faziam);
+      - maioresPorLinha: se > 0, de cada linha ficam so os k de maior |v|
+        (empate: a menor coluna), para limitar o fill-in de produtos iterados.
+    NaN nunca e descartado.
+*/
+
+struct Poda {
+    double tolerancia = 0.0;
+    int maioresPorLinha = 0;     // 0 = sem limite por linha
+
+    Poda() {}
+    explicit Poda(double tol, int k = 0) : tolerancia(tol), maioresPorLinha(k) {}
+
+    bool manter(double v) const { return !(fabs(v) <= tolerancia); }
+    bool limitaLinha() const { return maioresPorLinha > 0; }
+
+    // Aplica o limite por linha numa linha ja filtrada por manter() e
+    // ordenada por coluna; a saida continua ordenada por coluna
+    void limitar(vector<pair<int, double>>& linha) const {
+        if (!limitaLinha() || (int)linha.size() <= maioresPorLinha) return;
+        // NaN conta como o maior (e mantem a ordem estrita do nth_element)
+        auto chave = [](double v) { return isnan(v) ? INFINITY : fabs(v); };
+        auto maior = [&](const pair<int, double>& a, const pair<int, double>& b) {
+            double fa = chave(a.second), fb = chave(b.second);
+            return fa != fb ? fa > fb : a.first < b.first;
+        };
+        nth_element(linha.begin(), linha.begin() + maioresPorLinha, linha.end(), maior);
+        linha.resize(maioresPorLinha);
+        sort(linha.begin(), linha.end());
+    }
+};
@@ -0,0 +1,185 @@
+#pragma once
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include "alocacao.h"
+using namespace std;
+
+/*
+    -------------
+    [POOL DE NOS]
+    -------------
+    Os nos das estruturas esparsas sao alocados em blocos contiguos (slabs)
+    em vez de um `new` por elemento. Os blocos crescem geometricamente e os
+    nos removidos vao para uma lista de livres para serem reaproveitados.
+
+    Como os nos sao trivialmente copiaveis, uma copia inteira da estrutura
+    pode ser feita copiando os blocos com memcpy e depois corrigindo os
+    ponteiros (mesmo bloco, mesmo deslocamento) -- ver `copiarBlocosDe` e
+    `traduzir`.
+
+    Os blocos de 2 MB ou mais (minimoBytes) seguem a politica de paginas
+    grandes / NUMA de alocacao.h; os nos sao escritos primeiro pela thread
+    que insere, entao o primeiro toque ja cai no no dela.
+*/
+
+template <typename T>
+class PoolNos {
+    static_assert(is_trivially_copyable<T>::value, "PoolNos exige nos trivialmente copiaveis");
+
+private:
+    static constexpr size_t BLOCO_INICIAL = 64;
+    static constexpr size_t BLOCO_MAXIMO = 1 << 16;
+
+    vector<T*> blocos_;
+    vector<BlocoAlocado> regioes_;     // de onde veio cada bloco (para liberar)
+    vector<size_t> capacidades_;
+    vector<size_t> usados_;     // slots ja entregues em cada bloco
+    size_t vivos_ = 0;
+    vector<T*> livres_;
+
+    // (endereco inicial, indice do bloco), ordenado por endereco
+    vector<pair<uintptr_t, size_t>> ordenados_;
+
+    T* alocarBloco(size_t cap) {
+        regioes_.push_back(alocarRegiao(cap * sizeof(T)));
+        return static_cast<T*>(regioes_.back().p);
+    }
+
+    void registrarBloco(T* bloco, size_t cap) {
+        blocos_.push_back(bloco);
+        capacidades_.push_back(cap);
+        usados_.push_back(0);
+        pair<uintptr_t, size_t> e((uintptr_t)bloco, blocos_.size() - 1);
+        ordenados_.insert(upper_bound(ordenados_.begin(), ordenados_.end(), e), e);
+    }
+
+    void novoBloco(size_t minimo) {
+        size_t cap = capacidades_.empty() ? BLOCO_INICIAL : min(capacidades_.back() * 2, BLOCO_MAXIMO);
+        cap = max(cap, minimo);
+        registrarBloco(alocarBloco(cap), cap);
+    }
+
+    void liberarTudo() {
+        for (auto const& r : regioes_) liberarRegiao(r);
+        regioes_.clear();
+        blocos_.clear();
+        capacidades_.clear();
+        usados_.clear();
+        ordenados_.clear();
+        livres_.clear();
+        vivos_ = 0;
+    }
+
+    // indice do bloco que contem p (p precisa pertencer a este pool)
+    size_t blocoDe(const T* p) const {
+        uintptr_t a = (uintptr_t)p;
+        auto it = upper_bound(ordenados_.begin(), ordenados_.end(),
+                              pair<uintptr_t, size_t>(a, SIZE_MAX));
+        return (--it)->second;
+    }
+
+public:
+    PoolNos() {}
+    ~PoolNos() { liberarTudo(); }
+
+    PoolNos(const PoolNos&) = delete;
+    PoolNos& operator=(const PoolNos&) = delete;
+
+    PoolNos(PoolNos&& o) noexcept { trocar(o); }
+    PoolNos& operator=(PoolNos&& o) noexcept {
+        if (this != &o) {
+            liberarTudo();
+            trocar(o);
+        }
+        return *this;
+    }
+
+    void trocar(PoolNos& o) noexcept {
+        blocos_.swap(o.blocos_);
+        regioes_.swap(o.regioes_);
+        capacidades_.swap(o.capacidades_);
+        usados_.swap(o.usados_);
+        swap(vivos_, o.vivos_);
+        livres_.swap(o.livres_);
+        ordenados_.swap(o.ordenados_);
+    }
+
+    template <typename... Args>
+    T* alocar(Args&&... args) {
+        T* p;
+        if (!livres_.empty()) {
+            p = livres_.back();
+            livres_.pop_back();
+        } else {
+            if (blocos_.empty() || usados_.back() == capacidades_.back()) novoBloco(0);
+            p = blocos_.back() + usados_.back()++;
+        }
+        ++vivos_;
+        return new (p) T(std::forward<Args>(args)...);
+    }
+
+    void liberar(T* p) {
+        livres_.push_back(p);
+        --vivos_;
+    }
+
+    // Garante espaco para mais `n` nos sem precisar de um novo bloco no meio do caminho
+    void reservar(size_t n) {
+        size_t disponivel = livres_.size();
+        if (!blocos_.empty()) disponivel += capacidades_.back() - usados_.back();
+        if (disponivel < n) novoBloco(n - disponivel);
+    }
+
+    size_t tamanho() const { return vivos_; }
+    size_t livres() const { return livres_.size(); }
+
+    size_t bytesReservados() const {
+        size_t total = 0;
+        for (size_t c : capacidades_) total += c * sizeof(T);
+        return total;
+    }
+
+    // Copia os blocos de `o` em bloco (memcpy). Este pool precisa estar vazio.
+    // Depois da copia os ponteiros internos dos nos ainda apontam para `o`;
+    // quem chama corrige com `traduzir`.
+    void copiarBlocosDe(const PoolNos& o) {
+        liberarTudo();
+        blocos_.reserve(o.blocos_.size());
+        for (size_t b = 0; b < o.blocos_.size(); ++b) {
+            size_t cap = o.capacidades_[b];
+            T* novo = alocarBloco(cap);
+            memcpy((void*)novo, (const void*)o.blocos_[b], o.usados_[b] * sizeof(T));
+            blocos_.push_back(novo);
+            capacidades_.push_back(cap);
+            usados_.push_back(o.usados_[b]);
+        }
+        // os blocos novos ficam na mesma ordem de indice dos originais
+        for (size_t b = 0; b < blocos_.size(); ++b)
+            ordenados_.push_back(pair<uintptr_t, size_t>((uintptr_t)blocos_[b], b));
+        sort(ordenados_.begin(), ordenados_.end());
+
+        vivos_ = o.vivos_;
+        livres_.resize(o.livres_.size());
+        for (size_t k = 0; k < o.livres_.size(); ++k) livres_[k] = traduzir(o, o.livres_[k]);
+    }
+
+    // Ponteiro equivalente (mesmo bloco, mesmo deslocamento) a `p`, que pertence a `origem`
+    T* traduzir(const PoolNos& origem, T* p) const {
+        if (!p) return nullptr;
+        size_t b = origem.blocoDe(p);
+        return blocos_[b] + (p - origem.blocos_[b]);
+    }
+
+    // Percorre todos os slots ja entregues (inclusive os que estao na lista de livres)
+    template <typename F>
+    void paraCadaSlot(F f) {
+        for (size_t b = 0; b < blocos_.size(); ++b) {
+            T* base = blocos_[b];
+            for (size_t s = 0; s < usados_[b]; ++s) f(base + s);
+        }
+    }
+};
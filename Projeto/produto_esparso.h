@@ -0,0 +1,235 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+using namespace std;
+
+/*
+    -------------
+    [PRODUTO ESPARSO EM DUAS FASES]
+    -------------
+    Fase simbolica: calcula o padrao exato de nao-nulos de C = A*B (colunas
+    ordenadas de cada linha, no estilo CSR), para que a estrutura de C seja
+    pre-alocada de uma vez so.
+    Fase numerica: so acumula e escreve os valores no padrao ja conhecido.
+
+    O padrao fica guardado em `PadraoProduto` junto com a versao do padrao de
+    A e de B. Enquanto nenhuma das duas mudar de estrutura (so de valores), o
+    mesmo PadraoProduto pode ser reaproveitado e a fase simbolica e pulada.
+*/
+
+// Cada mudanca estrutural (insercao ou remocao de um nao-nulo) ganha um
+// numero novo; matrizes com a mesma versao tem o mesmo padrao.
+inline uint64_t novaVersaoPadrao() {
+    static atomic<uint64_t> contador(0);
+    return ++contador;
+}
+
+struct PadraoProduto {
+    int linhas = 0, colunas = 0;
+    // so as linhas de C com algum nao-nulo (nao guarda nada O(linhas),
+    // o que importa para as dimensoes de 10^8 dos testes)
+    vector<int> linhasPadrao;
+    vector<long long> inicio;        // linhasPadrao.size()+1 posicoes em colunasPadrao
+    vector<int> colunasPadrao;       // colunas de cada linha, em ordem crescente
+
+    // para validar o cache
+    uint64_t versaoA = 0, versaoB = 0;
+    bool transpostaA = false, transpostaB = false;
+    bool calculado = false;
+
+    long long nnz() const { return (long long)colunasPadrao.size(); }
+
+    bool valido(uint64_t vA, bool tA, uint64_t vB, bool tB) const {
+        return calculado && versaoA == vA && versaoB == vB
+            && transpostaA == tA && transpostaB == tB;
+    }
+
+    void iniciar(int l, int c) {
+        linhas = l;
+        colunas = c;
+        linhasPadrao.clear();
+        inicio.assign(1, 0);
+        colunasPadrao.clear();
+        calculado = false;
+    }
+
+    template <typename Acumulador>
+    void fecharLinha(int i, Acumulador& acc) {
+        size_t antes = colunasPadrao.size();
+        acc.extrairColunas(colunasPadrao);
+        if (colunasPadrao.size() == antes) return;
+        linhasPadrao.push_back(i);
+        inicio.push_back((long long)colunasPadrao.size());
+    }
+
+    void marcarCalculado(uint64_t vA, bool tA, uint64_t vB, bool tB) {
+        versaoA = vA; transpostaA = tA;
+        versaoB = vB; transpostaB = tB;
+        calculado = true;
+    }
+};
+
+// Numero de nao-nulos por linha e por coluna (so as nao vazias, ordenadas
+// pelo indice). Usado para estimar o custo de produtos sem calcula-los.
+struct EstatisticasPadrao {
+    int linhas = 0, colunas = 0;
+    double nnz = 0;
+    vector<pair<int, double>> porLinha;
+    vector<pair<int, double>> porColuna;
+};
+
+// Valor esperado de posicoes distintas ocupadas por x acertos uniformes em n posicoes
+inline double ocupacaoEsperada(double x, double n) {
+    if (n <= 0) return 0.0;
+    return n * -expm1(-x / n);
+}
+
+// flops de A*B: soma sobre k de nnz(coluna k de A) * nnz(linha k de B)
+inline double estimarFlops(const EstatisticasPadrao& A, const EstatisticasPadrao& B) {
+    double flops = 0.0;
+    size_t a = 0, b = 0;
+    while (a < A.porColuna.size() && b < B.porLinha.size()) {
+        if (A.porColuna[a].first < B.porLinha[b].first) ++a;
+        else if (A.porColuna[a].first > B.porLinha[b].first) ++b;
+        else flops += A.porColuna[a++].second * B.porLinha[b++].second;
+    }
+    return flops;
+}
+
+// Estatisticas estimadas de C = A*B a partir so das contagens de A e B.
+// Cada nao-nulo de A acerta em media flops/nnz(A) posicoes da sua linha em C
+// (e cada nao-nulo de B, flops/nnz(B) posicoes da sua coluna); as colisoes
+// sao descontadas supondo acertos uniformes (ocupacaoEsperada).
+inline EstatisticasPadrao estimarProduto(const EstatisticasPadrao& A, const EstatisticasPadrao& B) {
+    EstatisticasPadrao C;
+    C.linhas = A.linhas;
+    C.colunas = B.colunas;
+    double flops = estimarFlops(A, B);
+    if (flops == 0.0 || A.nnz == 0.0 || B.nnz == 0.0) return C;
+
+    double porNaoNuloA = flops / A.nnz;
+    double porNaoNuloB = flops / B.nnz;
+    double somaLinhas = 0.0, somaColunas = 0.0;
+    for (auto const& [i, c] : A.porLinha) {
+        double v = ocupacaoEsperada(c * porNaoNuloA, C.colunas);
+        C.porLinha.push_back(make_pair(i, v));
+        somaLinhas += v;
+    }
+    for (auto const& [j, c] : B.porColuna) {
+        double v = ocupacaoEsperada(c * porNaoNuloB, C.linhas);
+        C.porColuna.push_back(make_pair(j, v));
+        somaColunas += v;
+    }
+
+    // as duas somas estimam o mesmo nnz; fica a menor e as contagens sao reescaladas
+    C.nnz = min(somaLinhas, somaColunas);
+    for (auto& p : C.porLinha) p.second *= C.nnz / somaLinhas;
+    for (auto& p : C.porColuna) p.second *= C.nnz / somaColunas;
+    return C;
+}
+
+// Acumulador de uma linha de C. Usa um vetor denso + marcador (bitmap)
+// quando o numero de colunas e pequeno perto do trabalho do produto; para
+// dimensoes grandes com poucos elementos (10^8 nos testes) usa hash.
+class AcumuladorLinha {
+private:
+    static constexpr int LIMITE_DENSO = 1 << 22;
+
+    bool denso_;
+    vector<double> valores_;
+    vector<char> marcado_;
+    unordered_map<int, double> hash_;
+    vector<int> tocadas_;
+
+public:
+    AcumuladorLinha(int colunas, long long trabalho)
+        : denso_(colunas <= LIMITE_DENSO && (long long)colunas <= 16 * trabalho + 4096) {
+        if (denso_) {
+            valores_.assign(max(1, colunas), 0.0);
+            marcado_.assign(max(1, colunas), 0);
+        }
+    }
+
+    void marcar(int j) {
+        if (denso_) {
+            if (!marcado_[j]) { marcado_[j] = 1; tocadas_.push_back(j); }
+        } else if (hash_.emplace(j, 0.0).second) {
+            tocadas_.push_back(j);
+        }
+    }
+
+    // so pode ser chamado para colunas do padrao (ja conhecidas)
+    void somar(int j, double v) {
+        if (denso_) valores_[j] += v;
+        else hash_[j] += v;
+    }
+
+    double valor(int j) const {
+        if (denso_) return marcado_[j] ? valores_[j] : 0.0;
+        auto it = hash_.find(j);
+        return it == hash_.end() ? 0.0 : it->second;
+    }
+
+    // zera valores e marcas das posicoes usadas (uso como vetor esparso temporario)
+    void limpar() {
+        if (denso_) for (int j : tocadas_) { marcado_[j] = 0; valores_[j] = 0.0; }
+        else hash_.clear();
+        tocadas_.clear();
+    }
+
+    // le o valor acumulado de j e zera a posicao para a proxima linha
+    double retirar(int j) {
+        if (denso_) {
+            double v = valores_[j];
+            valores_[j] = 0.0;
+            return v;
+        }
+        auto it = hash_.find(j);
+        return it == hash_.end() ? 0.0 : it->second;
+    }
+
+    // colunas marcadas nesta linha; limpa as marcas
+    void extrairColunas(vector<int>& saida) {
+        sort(tocadas_.begin(), tocadas_.end());
+        saida.insert(saida.end(), tocadas_.begin(), tocadas_.end());
+        if (denso_) for (int j : tocadas_) marcado_[j] = 0;
+        else hash_.clear();
+        tocadas_.clear();
+    }
+
+    // fim de uma linha da fase numerica (depois de retirar todas as colunas)
+    void limparValores() {
+        if (!denso_) hash_.clear();
+    }
+};
+
+/*
+    Produto mascarado: C = (A*B) o M, calculando apenas as posicoes do
+    padrao de M. Para cada linha i de M a linha i de A e espalhada no
+    acumulador e cada C(i,j) e o produto interno dela com a coluna j de B,
+    entao o trabalho cresce com nnz(M) e nao com os flops de A*B.
+    Com usarValores=false M e so um padrao (mascara estrutural); com true
+    o resultado tambem e multiplicado pelos valores de M.
+*/
+template <typename Matriz, typename Mascara>
+void produtoMascarado(const Matriz& A, const Matriz& B, const Mascara& M,
+                      Matriz& C, bool usarValores) {
+    AcumuladorLinha linhaA(A.getColunas(), (long long)(A.getNaoNulos() + M.getNaoNulos()));
+    M.paraCadaLinhaNaoVazia([&](int i) {
+        A.paraCadaNaLinha(i, [&](int k, double v) {
+            linhaA.marcar(k);
+            linhaA.somar(k, v);
+        });
+        M.paraCadaNaLinha(i, [&](int j, double m) {
+            double soma = 0.0;
+            B.paraCadaNaColuna(j, [&](int k, double v) { soma += linhaA.valor(k) * v; });
+            if (usarValores) soma *= m;
+            if (soma != 0.0) C.set(i, j, soma);
+        });
+        linhaA.limpar();
+    });
+}
@@ -0,0 +1,95 @@
+#pragma once
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+/*
+    -------------
+    [SIMD PARA OS KERNELS DENSOS]
+    -------------
+    Um vetor de LARGURA_SIMD doubles com as poucas operacoes que os kernels
+    de linha da densa usam. AVX quando o compilador tem (-mavx,
+    -march=native), senao SSE2 (sempre presente em x86-64), senao um double
+    por vez -- o mesmo codigo compila em qualquer maquina. Cargas e escritas
+    sao desalinhadas: a densa e uma RegiaoContigua so (alocacao.h), com a
+    base alinhada em 2 MB quando a politica de paginas/NUMA vale para ela e
+    so em 16 (operator new comum) senao, e a linha i comeca em
+    base + i*colunas -- alinhada a 32 apenas se colunas for multiplo de 4.
+    Os acumuladores dos kernels sao vector<double>. Com endereco alinhado a
+    carga desalinhada custa o mesmo que a alinhada, entao nao vale testar.
+    O resto da linha (menos de LARGURA_SIMD posicoes) fica com o laco escalar
+    de quem chama.
+*/
+
+#if defined(__AVX__)
+typedef __m256d VetorSimd;
+static const int LARGURA_SIMD = 4;
+
+inline VetorSimd simdCarregar(const double* p) { return _mm256_loadu_pd(p); }
+inline void simdGuardar(double* p, VetorSimd v) { _mm256_storeu_pd(p, v); }
+inline VetorSimd simdRepetir(double x) { return _mm256_set1_pd(x); }
+inline VetorSimd simdSomar(VetorSimd a, VetorSimd b) { return _mm256_add_pd(a, b); }
+inline VetorSimd simdMultiplicar(VetorSimd a, VetorSimd b) { return _mm256_mul_pd(a, b); }
+inline VetorSimd simdMaximo(VetorSimd a, VetorSimd b) { return _mm256_max_pd(a, b); }
+inline VetorSimd simdMinimo(VetorSimd a, VetorSimd b) { return _mm256_min_pd(a, b); }
+// a onde m != 0, 0 onde m == 0; a mascara de bits tem o bit k ligado se a[k] != 0
+inline VetorSimd simdOndeNaoNulo(VetorSimd a, VetorSimd m) {
+    return _mm256_and_pd(a, _mm256_cmp_pd(m, _mm256_setzero_pd(), _CMP_NEQ_UQ));
+}
+inline VetorSimd simdAbsoluto(VetorSimd a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+inline int simdMascaraNaoNulos(VetorSimd a) {
+    return _mm256_movemask_pd(_mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_NEQ_UQ));
+}
+inline double simdSomaHorizontal(VetorSimd a) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+#elif defined(__SSE2__)
+typedef __m128d VetorSimd;
+static const int LARGURA_SIMD = 2;
+
+inline VetorSimd simdCarregar(const double* p) { return _mm_loadu_pd(p); }
+inline void simdGuardar(double* p, VetorSimd v) { _mm_storeu_pd(p, v); }
+inline VetorSimd simdRepetir(double x) { return _mm_set1_pd(x); }
+inline VetorSimd simdSomar(VetorSimd a, VetorSimd b) { return _mm_add_pd(a, b); }
+inline VetorSimd simdMultiplicar(VetorSimd a, VetorSimd b) { return _mm_mul_pd(a, b); }
+inline VetorSimd simdMaximo(VetorSimd a, VetorSimd b) { return _mm_max_pd(a, b); }
+inline VetorSimd simdMinimo(VetorSimd a, VetorSimd b) { return _mm_min_pd(a, b); }
+inline VetorSimd simdOndeNaoNulo(VetorSimd a, VetorSimd m) {
+    return _mm_and_pd(a, _mm_cmpneq_pd(m, _mm_setzero_pd()));
+}
+inline VetorSimd simdAbsoluto(VetorSimd a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+inline int simdMascaraNaoNulos(VetorSimd a) { return _mm_movemask_pd(_mm_cmpneq_pd(a, _mm_setzero_pd())); }
+inline double simdSomaHorizontal(VetorSimd a) { return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a))); }
+#else
+typedef double VetorSimd;
+static const int LARGURA_SIMD = 1;
+
+inline VetorSimd simdCarregar(const double* p) { return *p; }
+inline void simdGuardar(double* p, VetorSimd v) { *p = v; }
+inline VetorSimd simdRepetir(double x) { return x; }
+inline VetorSimd simdSomar(VetorSimd a, VetorSimd b) { return a + b; }
+inline VetorSimd simdMultiplicar(VetorSimd a, VetorSimd b) { return a * b; }
+inline VetorSimd simdMaximo(VetorSimd a, VetorSimd b) { return a > b ? a : b; }
+inline VetorSimd simdMinimo(VetorSimd a, VetorSimd b) { return a < b ? a : b; }
+inline VetorSimd simdOndeNaoNulo(VetorSimd a, VetorSimd m) { return m != 0.0 ? a : 0.0; }
+inline VetorSimd simdAbsoluto(VetorSimd a) { return a < 0 ? -a : a; }
+inline int simdMascaraNaoNulos(VetorSimd a) { return a != 0.0; }
+inline double simdSomaHorizontal(VetorSimd a) { return a; }
+#endif
+
+//ESCALARES (resto das linhas, com a mesma semantica dos vetores)
+// max/min como maxpd/minpd: com NaN vale o segundo operando
+inline double escalarMaximo(double a, double b) { return a > b ? a : b; }
+inline double escalarMinimo(double a, double b) { return a < b ? a : b; }
+inline double escalarOndeNaoNulo(double a, double m) { return m != 0.0 ? a : 0.0; }
+
+//AXPY: y[0..n) += a * x[0..n)
+inline void simdAxpy(double* y, const double* x, double a, int n) {
+    VetorSimd va = simdRepetir(a);
+    int j = 0;
+    for (; j + LARGURA_SIMD <= n; j += LARGURA_SIMD)
+        simdGuardar(y + j, simdSomar(simdCarregar(y + j), simdMultiplicar(va, simdCarregar(x + j))));
+    for (; j < n; ++j) y[j] += a * x[j];
+}
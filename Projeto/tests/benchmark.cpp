@@ -0,0 +1,12 @@
+#include "suite.h"
+
+using namespace std;
+
+// Executavel unico dos benchmarks: tudo escolhido pela linha de comando
+// (--ajuda lista as opcoes). Sem opcoes roda todas as operacoes e
+// estruturas para N = 10^2 ... 10^5 nas esparsidades do projeto.
+// Ex.: benchmark.out --ops=SOMA,MULT --estruturas=hash,tree --k=1e3:1e5:x10
+//          --dims=20000 --threads=1,2,4 --formato=json --saida=res.json
+int main(int argc, char** argv) {
+    return executarSuite(argc, argv);
+}
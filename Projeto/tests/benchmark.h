@@ -0,0 +1,317 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <type_traits>
+#include "util_medicao.h"
+#include "contadores.h"
+#include "../paralelo.h"
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace std;
+
+/*
+    -------------
+    [MICRO-BENCHMARK]
+    -------------
+    Substitui o "cronometra uma chamada e tira a mediana de 3": operacoes
+    rapidas (transpor() O(1), matrizes 100x100) ficavam abaixo da resolucao
+    do relogio. Cada medicao:
+      1) calibra: repete a operacao ate uma amostra durar pelo menos
+         tempoAlvoAmostra_ns (a calibracao tambem serve de aquecimento);
+      2) coleta ate `amostras` amostras sem passar de tempoMaximo_ns;
+      3) descarta outliers pelas cercas de Tukey (1.5 * IQR);
+      4) devolve mediana, media, desvio e IC de 95% da media (t de Student)
+         por execucao da operacao.
+    Operacoes que so valem uma vez sobre o mesmo estado (SET numa matriz
+    nova, construcao) usam medirComPreparo: o preparo roda fora do relogio
+    antes de cada execucao e nao ha repeticao dentro da amostra.
+
+    Variaveis de ambiente:
+      MC458_CPU=n          fixa o processo na CPU n (e usa 1 thread: as
+                           threads dos kernels herdariam a mesma CPU)
+      MC458_AMOSTRAS=n     amostras por medicao
+      MC458_TEMPO_MAX_MS=n teto de tempo por medicao
+      MC458_CONTADORES=1   contadores de hardware (ver contadores.h)
+*/
+
+// Impede o compilador de descartar um valor calculado so para medir tempo
+// (no lugar do antigo `volatile double dummy`)
+template <typename T>
+inline void naoOtimizar(const T& valor) {
+    asm volatile("" : : "r,m"(valor) : "memory");
+}
+
+template <typename T>
+inline void naoOtimizar(T& valor) {
+    asm volatile("" : "+r,m"(valor) : : "memory");
+}
+
+// Escritas pendentes na memoria precisam acontecer antes deste ponto
+inline void barreiraMemoria() {
+    asm volatile("" : : : "memory");
+}
+
+struct OpcoesMedicao {
+    int amostras = 15;
+    long long tempoAlvoAmostra_ns = 1000000;      // 1 ms por amostra
+    long long tempoMaximo_ns = 2000000000LL;      // 2 s por medicao
+    long long maxIteracoes = 1LL << 24;           // por amostra
+};
+
+inline OpcoesMedicao& opcoesMedicao() {
+    static OpcoesMedicao o;
+    return o;
+}
+
+// Resultado por execucao da operacao. Mediana -1 = nao medido (mesma
+// convencao do CSV antigo).
+struct Medicao {
+    double mediana_ns = -1;
+    double media_ns = -1;
+    double desvio_ns = -1;
+    double icInferior_ns = -1, icSuperior_ns = -1;
+    int amostras = 0;
+    int descartadas = 0;
+    long long iteracoes = 0;    // execucoes por amostra
+    LeituraContadores contadores;   // media por execucao, em todas as amostras
+    vector<double> tempos;      // tempo por execucao de cada amostra mantida (ordenado)
+
+    bool valida() const { return mediana_ns >= 0; }
+};
+
+//FIXAR CPU
+inline bool fixarCPU(int cpu) {
+#ifdef __linux__
+    cpu_set_t conjunto;
+    CPU_ZERO(&conjunto);
+    CPU_SET(cpu, &conjunto);
+    return sched_setaffinity(0, sizeof(conjunto), &conjunto) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+inline void configurarMedicao() {
+    if (const char* s = getenv("MC458_AMOSTRAS")) opcoesMedicao().amostras = max(1, atoi(s));
+    if (const char* s = getenv("MC458_TEMPO_MAX_MS")) opcoesMedicao().tempoMaximo_ns = max(1LL, atoll(s)) * 1000000LL;
+    if (const char* s = getenv("MC458_CPU")) {
+        if (fixarCPU(atoi(s))) definirNumThreads(1);
+        else cerr << "nao foi possivel fixar a CPU " << s << endl;
+    }
+}
+
+// quantil 0.975 da t de Student com gl graus de liberdade
+inline double quantilT975(int gl) {
+    static const double tabela[] = {0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+                                    2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+                                    2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (gl <= 0) return 0.0;
+    if (gl <= 30) return tabela[gl];
+    return 1.96 + 2.4 / gl;
+}
+
+// Estatisticas de tempos por execucao, sem os outliers
+inline Medicao resumirAmostras(vector<double> t, long long iteracoes) {
+    Medicao m;
+    if (t.empty()) return m;
+    sort(t.begin(), t.end());
+    m.iteracoes = iteracoes;
+
+    auto quantil = [](const vector<double>& v, double q) {
+        double pos = q * (double)(v.size() - 1);
+        size_t a = (size_t)pos;
+        size_t b = min(a + 1, v.size() - 1);
+        return v[a] + (v[b] - v[a]) * (pos - (double)a);
+    };
+
+    if (t.size() >= 5) {
+        double q1 = quantil(t, 0.25), q3 = quantil(t, 0.75);
+        double iqr = q3 - q1;
+        double lo = q1 - 1.5 * iqr, hi = q3 + 1.5 * iqr;
+        vector<double> mantidas;
+        for (double x : t)
+            if (x >= lo && x <= hi) mantidas.push_back(x);
+        m.descartadas = (int)(t.size() - mantidas.size());
+        t.swap(mantidas);
+    }
+    m.tempos = t;
+
+    int n = (int)t.size();
+    m.amostras = n;
+    m.mediana_ns = quantil(t, 0.5);
+    double soma = 0;
+    for (double x : t) soma += x;
+    m.media_ns = soma / n;
+    double var = 0;
+    for (double x : t) var += (x - m.media_ns) * (x - m.media_ns);
+    m.desvio_ns = n > 1 ? sqrt(var / (n - 1)) : 0.0;
+    double meiaLargura = n > 1 ? quantilT975(n - 1) * m.desvio_ns / sqrt((double)n) : 0.0;
+    m.icInferior_ns = m.media_ns - meiaLargura;
+    m.icSuperior_ns = m.media_ns + meiaLargura;
+    return m;
+}
+
+// Executa f `vezes` vezes e devolve o tempo total. Se f devolve um valor
+// (ex.: a matriz de uma soma) ele so e destruido depois do cronometro.
+template <typename F>
+long long cronometrarRepeticoes(F& f, long long vezes) {
+    using R = decltype(f());
+    Cronometro cron;
+    if constexpr (is_void<R>::value) {
+        cron.comecar();
+        for (long long r = 0; r < vezes; ++r) {
+            f();
+            barreiraMemoria();
+        }
+        return cron.finalizar();
+    } else {
+        vector<R> resultados;
+        resultados.reserve((size_t)vezes);
+        cron.comecar();
+        for (long long r = 0; r < vezes; ++r) {
+            resultados.push_back(f());
+            naoOtimizar(resultados.back());
+        }
+        return cron.finalizar();   // resultados sao destruidos depois
+    }
+}
+
+//MEDIR (operacao repetivel)
+// memoria: se dado, recebe o pico de memoria da primeira execucao (inclui
+// o resultado, se f devolver um)
+template <typename F>
+Medicao medir(F f, long long* memoria = nullptr, const OpcoesMedicao& o = opcoesMedicao()) {
+    long long gasto = 0;
+
+    ContadoresHardware& hw = contadoresHardware();
+
+    // primeira execucao: memoria, aquecimento e estimativa do custo
+    if (memoria) start_tracking();
+    hw.iniciar();
+    long long t1 = cronometrarRepeticoes(f, 1);
+    LeituraContadores c1 = hw.parar();
+    if (memoria) { *memoria = get_tracked_bytes(); stop_tracking(); }
+    gasto += t1;
+    if (t1 >= o.tempoMaximo_ns) {
+        Medicao m = resumirAmostras({(double)t1}, 1);
+        m.contadores = c1;
+        return m;
+    }
+
+    // calibracao: dobra as repeticoes ate a amostra passar do alvo
+    long long iteracoes = 1;
+    long long tAmostra = t1;
+    while (tAmostra < o.tempoAlvoAmostra_ns && iteracoes < o.maxIteracoes && gasto < o.tempoMaximo_ns / 4) {
+        iteracoes = min(o.maxIteracoes, iteracoes * 2);
+        tAmostra = cronometrarRepeticoes(f, iteracoes);
+        gasto += tAmostra;
+    }
+
+    vector<double> porExecucao;
+    porExecucao.reserve(o.amostras);
+    LeituraContadores soma;
+    for (int a = 0; a < o.amostras; ++a) {
+        if (a > 0 && gasto + tAmostra > o.tempoMaximo_ns) break;
+        hw.iniciar();
+        long long t = cronometrarRepeticoes(f, iteracoes);
+        soma.somar(hw.parar());
+        gasto += t;
+        porExecucao.push_back((double)t / (double)iteracoes);
+    }
+    Medicao m = resumirAmostras(porExecucao, iteracoes);
+    m.contadores = soma.porExecucao((long long)porExecucao.size() * iteracoes);
+    return m;
+}
+
+//MEDIR COM PREPARO (operacao que consome o estado)
+// preparo() roda fora do relogio antes de cada execucao de f()
+template <typename P, typename F>
+Medicao medirComPreparo(P preparo, F f, long long* memoria = nullptr, const OpcoesMedicao& o = opcoesMedicao()) {
+    Cronometro cron;
+    ContadoresHardware& hw = contadoresHardware();
+    LeituraContadores ultima;
+    auto umaVez = [&]() {
+        preparo();
+        barreiraMemoria();
+        hw.iniciar();
+        cron.comecar();
+        f();
+        barreiraMemoria();
+        long long t = cron.finalizar();
+        ultima = hw.parar();
+        return t;
+    };
+
+    // primeira execucao: memoria e aquecimento
+    preparo();
+    if (memoria) start_tracking();
+    hw.iniciar();
+    cron.comecar();
+    f();
+    barreiraMemoria();
+    long long t1 = cron.finalizar();
+    LeituraContadores c1 = hw.parar();
+    if (memoria) { *memoria = get_tracked_bytes(); stop_tracking(); }
+    if (t1 >= o.tempoMaximo_ns) {
+        Medicao m = resumirAmostras({(double)t1}, 1);
+        m.contadores = c1;
+        return m;
+    }
+
+    long long gasto = t1;
+    vector<double> tempos;
+    tempos.reserve(o.amostras);
+    LeituraContadores soma;
+    for (int a = 0; a < o.amostras; ++a) {
+        if (a > 0 && gasto + t1 > o.tempoMaximo_ns) break;
+        long long t = umaVez();
+        soma.somar(ultima);
+        gasto += t;
+        tempos.push_back((double)t);
+    }
+    Medicao m = resumirAmostras(tempos, 1);
+    m.contadores = soma.porExecucao((long long)tempos.size());
+    return m;
+}
+
+//SAIDA CSV
+// Colunas acrescentadas ao CSV de cada teste, depois das colunas antigas
+inline string colunasMedicao() {
+    return string("Media_ns,Desvio_ns,IC95_Inf_ns,IC95_Sup_ns,Amostras,Iteracoes,Descartadas,") + colunasContadores();
+}
+
+inline string formatarNs(double ns) {
+    char buf[64];
+    if (fabs(ns) >= 1000) snprintf(buf, sizeof(buf), "%.0f", ns);
+    else snprintf(buf, sizeof(buf), "%.2f", ns);
+    return buf;
+}
+
+// Tempo_ns do CSV (mediana por execucao)
+inline string tempoCSV(const Medicao& m) {
+    return m.valida() ? formatarNs(m.mediana_ns) : "-1";
+}
+
+inline void escreverColunasMedicao(ostream& out, const Medicao& m) {
+    if (!m.valida()) {
+        out << "-1,-1,-1,-1,0,0,0,";
+        escreverColunasContadores(out, LeituraContadores());
+        return;
+    }
+    out << formatarNs(m.media_ns) << ","
+        << formatarNs(m.desvio_ns) << ","
+        << formatarNs(m.icInferior_ns) << ","
+        << formatarNs(m.icSuperior_ns) << ","
+        << m.amostras << ","
+        << m.iteracoes << ","
+        << m.descartadas << ",";
+    escreverColunasContadores(out, m.contadores);
+}
@@ -0,0 +1,335 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "relatorio.h"
+#include "../gerador.h"   // splitmix64
+
+using namespace std;
+
+/*
+    -------------
+    [COMPARACAO COM BASELINE]
+    -------------
+    Compara os tempos de uma rodada com um CSV de referencia, ponto a ponto
+    (operacao, estrutura, N ou k, esparsidade, carga e threads, quando os
+    dois lados tem a coluna). "Est1(Hash)" e "Hash" sao a mesma estrutura,
+    entao os CSVs historicos (analise/resultados_operacoes.csv e o
+    benchmark.csv dos numeros grandes) tambem servem de baseline.
+
+    Amostras de cada lado: os tempos por execucao da coluna Amostras_ns;
+    sem ela (CSVs antigos), o Tempo_ns de cada linha. Linhas repetidas do
+    mesmo ponto (varias sementes, varias rodadas) sao juntadas.
+
+    Razao = mediana atual / mediana baseline, com IC de 95% por bootstrap
+    (quando os dois lados tem repeticoes).
+    Teste (unilateral, na direcao da razao): Mann-Whitney, exato (todas as
+    divisoes dos postos, empates com posto medio) ate LIMITE_MW_EXATO
+    amostras no total, aproximacao normal acima. So ha teste com pelo
+    menos 2 amostras de cada lado e quando o menor p possivel,
+    1 / C(n1 + n2, n1), fica abaixo de alfa (2 x 2 e 3 x 3 nunca chegam
+    a 0,05).
+    LENTO = razao > 1 + limiar e p < alfa; RAPIDO = o simetrico.
+    Sem teste possivel -- em especial com uma amostra so no baseline, como
+    nos CSVs historicos -- o veredito e so pela razao (Teste = "razao"):
+    LENTO se razao > 1 + limiar, e o executavel falha do mesmo jeito.
+*/
+
+struct ChaveComparacao {
+    string operacao, estrutura, tamanho, esparsidade, carga, threads;
+
+    bool operator<(const ChaveComparacao& o) const {
+        return tie(operacao, estrutura, tamanho, esparsidade, carga, threads) <
+               tie(o.operacao, o.estrutura, o.tamanho, o.esparsidade, o.carga, o.threads);
+    }
+};
+
+struct TabelaTempos {
+    string colunaTamanho = "N";
+    bool temThreads = false;
+    map<ChaveComparacao, vector<double>> tempos;
+};
+
+struct OpcoesComparacao {
+    double limiar = 0.05;   // piora minima que conta (5%)
+    double alfa = 0.05;
+    int reamostras = 2000;
+};
+
+// "Est1(Hash)" -> "Hash", "Est2(Tree)" -> "Tree"
+inline string estruturaCanonica(const string& e) {
+    size_t a = e.find('('), b = e.rfind(')');
+    if (a != string::npos && b != string::npos && b > a) return e.substr(a + 1, b - a - 1);
+    return e;
+}
+
+inline string esparsidadeCanonica(double e) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.6g", e);
+    return buf;
+}
+
+inline void adicionarTempos(TabelaTempos& t, ChaveComparacao c, const vector<double>& v) {
+    c.estrutura = estruturaCanonica(c.estrutura);
+    vector<double>& destino = t.tempos[c];
+    destino.insert(destino.end(), v.begin(), v.end());
+}
+
+// Tabela dos resultados da rodada atual
+inline TabelaTempos tabelaDeResultados(const vector<Resultado>& resultados, const string& colunaTamanho) {
+    TabelaTempos t;
+    t.colunaTamanho = colunaTamanho;
+    t.temThreads = true;
+    for (const Resultado& r : resultados) {
+        if (!r.tempo.valida()) continue;
+        ChaveComparacao c{r.operacao, r.estrutura, to_string(r.tamanho), esparsidadeCanonica(r.esparsidade),
+                          r.carga, to_string(r.threads)};
+        adicionarTempos(t, c, r.tempo.tempos.empty() ? vector<double>{r.tempo.mediana_ns} : r.tempo.tempos);
+    }
+    return t;
+}
+
+// CSV dos testes, novo ou antigo (linhas '#' ignoradas)
+inline bool lerTabelaCSV(const string& caminho, TabelaTempos& t) {
+    ifstream f(caminho);
+    if (!f) {
+        cerr << "nao foi possivel abrir " << caminho << endl;
+        return false;
+    }
+    string linha;
+    map<string, int> col;
+    while (getline(f, linha)) {
+        if (!linha.empty() && linha.back() == '\r') linha.pop_back();
+        if (linha.empty() || linha[0] == '#') continue;
+        vector<string> campos = separar(linha, ',');
+        if (col.empty()) {
+            for (size_t i = 0; i < campos.size(); ++i) col[campos[i]] = (int)i;
+            t.colunaTamanho = col.count("N") ? "N" : "k";
+            t.temThreads = col.count("Threads") > 0;
+            for (const char* obrigatoria : {"Operacao", "Estrutura", "Esparsidade", "Tempo_ns"}) {
+                if (!col.count(obrigatoria) || !col.count(t.colunaTamanho)) {
+                    cerr << caminho << ": falta a coluna " << (col.count(obrigatoria) ? t.colunaTamanho : obrigatoria) << endl;
+                    return false;
+                }
+            }
+            continue;
+        }
+        auto campo = [&](const string& nome) -> string {
+            auto it = col.find(nome);
+            return it != col.end() && it->second < (int)campos.size() ? campos[it->second] : "";
+        };
+        double tempo = atof(campo("Tempo_ns").c_str());
+        if (tempo < 0) continue;   // nao medido
+
+        ChaveComparacao c;
+        c.operacao = campo("Operacao");
+        c.estrutura = campo("Estrutura");
+        c.tamanho = campo(t.colunaTamanho);
+        c.esparsidade = esparsidadeCanonica(atof(campo("Esparsidade").c_str()));
+        c.carga = col.count("Carga") ? campo("Carga") : "uniforme";
+        c.threads = campo("Threads");
+
+        vector<double> v;
+        for (const string& a : separar(campo("Amostras_ns"), ';'))
+            if (!a.empty()) v.push_back(atof(a.c_str()));
+        if (v.empty()) v.push_back(tempo);
+        adicionarTempos(t, c, v);
+    }
+    return !col.empty();
+}
+
+// Sem a coluna Threads dos dois lados, os pontos de threads diferentes se juntam
+inline TabelaTempos semThreads(const TabelaTempos& t) {
+    TabelaTempos r;
+    r.colunaTamanho = t.colunaTamanho;
+    for (auto& p : t.tempos) {
+        ChaveComparacao c = p.first;
+        c.threads = "";
+        adicionarTempos(r, c, p.second);
+    }
+    return r;
+}
+
+//ESTATISTICA
+inline double medianaDe(vector<double> v) {
+    sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+inline double normalAcumulada(double z) {
+    return 0.5 * erfc(-z / sqrt(2.0));
+}
+
+// Postos medios (dobrados, para ficarem inteiros) de atual ++ base, na
+// ordem de entrada; empates somam t^3 - t em `empates`
+inline vector<long long> postosDobrados(const vector<double>& atual, const vector<double>& base, double& empates) {
+    size_t n = atual.size() + base.size();
+    vector<pair<double, size_t>> todos;
+    for (double x : atual) todos.push_back({x, todos.size()});
+    for (double x : base) todos.push_back({x, todos.size()});
+    sort(todos.begin(), todos.end());
+    vector<long long> postos(n);
+    empates = 0;
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && todos[j].first == todos[i].first) ++j;
+        for (size_t q = i; q < j; ++q) postos[todos[q].second] = (long long)(i + j + 1);   // 2 * media de i+1..j
+        double tam = (double)(j - i);
+        empates += tam * tam * tam - tam;
+        i = j;
+    }
+    return postos;
+}
+
+static const size_t LIMITE_MW_EXATO = 50;
+
+// 1 / C(n1 + n2, n1): o menor p que o teste exato consegue dar
+inline double pMinimoMannWhitney(size_t n1, size_t n2) {
+    double c = 1;
+    for (size_t k = 1; k <= n1; ++k) c = c * (double)(n2 + k) / (double)k;
+    return 1.0 / c;
+}
+
+// P(atual tende a ser maior que base), unilateral; maior = false testa o
+// contrario. Exato ate LIMITE_MW_EXATO amostras: distribuicao da soma dos
+// postos de `atual` em todas as C(n, n1) escolhas (programacao dinamica
+// sobre os postos dobrados). Acima, aproximacao normal com correcao de
+// empates e de continuidade.
+inline double pMannWhitney(const vector<double>& atual, const vector<double>& base, bool maior) {
+    size_t n1 = atual.size(), n2 = base.size(), n = n1 + n2;
+    double empates;
+    vector<long long> postos = postosDobrados(atual, base, empates);
+    long long soma = 0, total = 0;
+    for (size_t i = 0; i < n1; ++i) soma += postos[i];
+    for (long long r : postos) total += r;
+
+    if (n <= LIMITE_MW_EXATO) {
+        // cont[k][s]: escolhas de k postos com soma s
+        vector<vector<double>> cont(n1 + 1, vector<double>((size_t)total + 1, 0.0));
+        cont[0][0] = 1;
+        for (size_t r = 0; r < n; ++r)
+            for (size_t k = min(r + 1, n1); k >= 1; --k)
+                for (long long s = total; s >= postos[r]; --s)
+                    cont[k][s] += cont[k - 1][s - postos[r]];
+        double todas = 0, extremas = 0;
+        for (long long s = 0; s <= total; ++s) {
+            todas += cont[n1][s];
+            if (maior ? s >= soma : s <= soma) extremas += cont[n1][s];
+        }
+        return todas > 0 ? extremas / todas : 1.0;
+    }
+
+    double u = (double)soma / 2.0 - (double)n1 * (n1 + 1) / 2.0;
+    double media = (double)n1 * n2 / 2.0;
+    double var = (double)n1 * n2 / 12.0 * ((n + 1) - empates / ((double)n * (n - 1)));
+    if (var <= 0) return 1.0;
+    double z = maior ? (u - media - 0.5) / sqrt(var) : (media - u - 0.5) / sqrt(var);
+    return 1.0 - normalAcumulada(z);
+}
+
+struct Reamostragem {
+    double icInferior, icSuperior;
+};
+
+// Bootstrap da razao das medianas (sorteios reprodutiveis)
+inline Reamostragem bootstrapRazao(const vector<double>& atual, const vector<double>& base, int reamostras) {
+    vector<double> razoes;
+    razoes.reserve(reamostras);
+    vector<double> a(atual.size()), b(base.size());
+    uint64_t estado = 458;
+    auto sortear = [&](size_t n) { return (size_t)(splitmix64(++estado) % n); };
+    for (int r = 0; r < reamostras; ++r) {
+        for (double& x : a) x = atual[sortear(atual.size())];
+        for (double& x : b) x = base[sortear(base.size())];
+        double mb = medianaDe(b);
+        razoes.push_back(mb > 0 ? medianaDe(a) / mb : 1.0);
+    }
+    sort(razoes.begin(), razoes.end());
+    Reamostragem s;
+    s.icInferior = razoes[(size_t)(0.025 * (reamostras - 1))];
+    s.icSuperior = razoes[(size_t)(0.975 * (reamostras - 1))];
+    return s;
+}
+
+//COMPARACAO
+struct LinhaComparacao {
+    ChaveComparacao chave;
+    double base_ns, atual_ns, razao;
+    double icInferior = -1, icSuperior = -1, p = -1;
+    string teste, veredito;
+};
+
+inline LinhaComparacao compararPonto(const ChaveComparacao& c, const vector<double>& atual,
+                                     const vector<double>& base, const OpcoesComparacao& o) {
+    LinhaComparacao l;
+    l.chave = c;
+    l.base_ns = medianaDe(base);
+    l.atual_ns = medianaDe(atual);
+    l.razao = l.base_ns > 0 ? l.atual_ns / l.base_ns : 1.0;
+    bool piorou = l.razao >= 1.0;
+
+    bool repeticoes = atual.size() >= 2 && base.size() >= 2;
+    if (repeticoes) {
+        Reamostragem b = bootstrapRazao(atual, base, o.reamostras);
+        l.icInferior = b.icInferior;
+        l.icSuperior = b.icSuperior;
+    }
+    // com poucas amostras o teste nao consegue dar p < alfa: vale a razao
+    bool significativo = true;
+    if (repeticoes && pMinimoMannWhitney(atual.size(), base.size()) < o.alfa) {
+        l.teste = "mann_whitney";
+        l.p = pMannWhitney(atual, base, piorou);
+        significativo = l.p < o.alfa;
+    } else {
+        l.teste = "razao";
+    }
+
+    if (significativo && l.razao > 1.0 + o.limiar) l.veredito = "LENTO";
+    else if (significativo && l.razao < 1.0 / (1.0 + o.limiar)) l.veredito = "RAPIDO";
+    else l.veredito = "igual";
+    return l;
+}
+
+// Escreve a comparacao em CSV e devolve o numero de pontos LENTO
+inline int compararTabelas(TabelaTempos atual, TabelaTempos base, const OpcoesComparacao& o, ostream& out) {
+    if (atual.colunaTamanho != base.colunaTamanho)
+        cerr << "comparacao: baseline por " << base.colunaTamanho << ", rodada por " << atual.colunaTamanho
+             << " (nenhum ponto em comum)" << endl;
+    if (!atual.temThreads || !base.temThreads) {
+        atual = semThreads(atual);
+        base = semThreads(base);
+    }
+
+    out << "Operacao,Estrutura," << atual.colunaTamanho << ",Esparsidade,Carga,Threads,Base_ns,Atual_ns,"
+        << "Razao,Razao_IC95_Inf,Razao_IC95_Sup,p_valor,Teste,Resultado\n";
+    int lentos = 0, rapidos = 0, soRazao = 0, pontos = 0;
+    for (auto& p : atual.tempos) {
+        auto it = base.tempos.find(p.first);
+        if (it == base.tempos.end()) continue;
+        LinhaComparacao l = compararPonto(p.first, p.second, it->second, o);
+        const ChaveComparacao& c = l.chave;
+        char nums[160];
+        snprintf(nums, sizeof(nums), "%.4f,%.4f,%.4f,%.4g", l.razao, l.icInferior, l.icSuperior, l.p);
+        out << c.operacao << "," << c.estrutura << "," << c.tamanho << "," << c.esparsidade << ","
+            << c.carga << "," << c.threads << "," << formatarNs(l.base_ns) << "," << formatarNs(l.atual_ns)
+            << "," << nums << "," << l.teste << "," << l.veredito << "\n";
+        ++pontos;
+        lentos += l.veredito == "LENTO";
+        rapidos += l.veredito == "RAPIDO";
+        soRazao += l.teste == "razao";
+    }
+    out.flush();
+    cerr << "comparacao: " << pontos << " pontos em comum, " << lentos << " mais lentos, " << rapidos
+         << " mais rapidos, " << soRazao << " so pela razao, sem amostras para o teste (limiar " << o.limiar * 100 << "%, alfa " << o.alfa
+         << ")" << endl;
+    return lentos;
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+using namespace std;
+
+/*
+    -------------
+    [CONTADORES DE HARDWARE]
+    -------------
+    Ciclos, instrucoes, misses de L1D / LLC / dTLB e desvios mal previstos
+    via perf_event_open, em volta de qualquer regiao medida (a mesma que o
+    Cronometro mede). Cada contador e aberto sozinho com inherit=1, entao as
+    threads criadas pelos kernels paralelos dentro da regiao tambem contam.
+    Se o kernel multiplexar os contadores, o valor e escalado por
+    tempo_habilitado / tempo_rodando.
+    Com inherit=1 o PERF_EVENT_IOC_RESET nao zera o que as threads filhas
+    ja somaram, entao a regiao e sempre a diferenca de duas leituras
+    (valor e os dois tempos), uma no inicio e outra no fim.
+
+    Opcional: so liga com MC458_CONTADORES=1. Sem permissao
+    (perf_event_paranoid, container sem PMU) o contador fica indisponivel,
+    aparece como -1 no CSV e o teste segue normalmente.
+*/
+
+enum IndiceContador { CICLOS, INSTRUCOES, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, DTLB_MISSES, NUM_CONTADORES };
+
+inline const char* colunasContadores() {
+    return "Ciclos,Instrucoes,L1D_Misses,LLC_Misses,Branch_Misses,DTLB_Misses";
+}
+
+// Soma de leituras; valor < 0 = contador indisponivel
+struct LeituraContadores {
+    double valor[NUM_CONTADORES];
+
+    LeituraContadores() {
+        for (int c = 0; c < NUM_CONTADORES; ++c) valor[c] = -1;
+    }
+
+    bool algumDisponivel() const {
+        for (int c = 0; c < NUM_CONTADORES; ++c)
+            if (valor[c] >= 0) return true;
+        return false;
+    }
+
+    void somar(const LeituraContadores& o) {
+        for (int c = 0; c < NUM_CONTADORES; ++c) {
+            if (o.valor[c] < 0) continue;
+            valor[c] = (valor[c] < 0 ? 0 : valor[c]) + o.valor[c];
+        }
+    }
+
+    // media por execucao
+    LeituraContadores porExecucao(long long execucoes) const {
+        LeituraContadores r;
+        for (int c = 0; c < NUM_CONTADORES; ++c)
+            if (valor[c] >= 0 && execucoes > 0) r.valor[c] = valor[c] / (double)execucoes;
+        return r;
+    }
+};
+
+class ContadoresHardware {
+private:
+    int fd_[NUM_CONTADORES];
+    bool aberto_ = false;
+    bool ligado_ = false;
+    uint64_t inicio_[NUM_CONTADORES][3];   // leitura no iniciar(): valor, habilitado, rodando
+
+#ifdef __linux__
+    static int abrirContador(uint32_t tipo, uint64_t config) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = tipo;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    // valor, tempo habilitado, tempo rodando (acumulados desde a abertura)
+    static bool ler(int fd, uint64_t dados[3]) {
+        return read(fd, dados, 3 * sizeof(uint64_t)) == (ssize_t)(3 * sizeof(uint64_t));
+    }
+
+    static uint64_t cache(uint64_t nivel) {
+        return nivel | ((uint64_t)PERF_COUNT_HW_CACHE_OP_READ << 8) | ((uint64_t)PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    }
+#endif
+
+    void abrir() {
+        aberto_ = true;
+        for (int c = 0; c < NUM_CONTADORES; ++c) fd_[c] = -1;
+        const char* env = getenv("MC458_CONTADORES");
+        if (!env || string(env) == "0") return;
+        int erro = ENOSYS;
+#ifdef __linux__
+        const uint32_t tipo[NUM_CONTADORES] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+                                               PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE};
+        const uint64_t config[NUM_CONTADORES] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                 cache(PERF_COUNT_HW_CACHE_L1D), cache(PERF_COUNT_HW_CACHE_LL),
+                                                 PERF_COUNT_HW_BRANCH_MISSES, cache(PERF_COUNT_HW_CACHE_DTLB)};
+        erro = 0;
+        for (int c = 0; c < NUM_CONTADORES; ++c) {
+            fd_[c] = abrirContador(tipo[c], config[c]);
+            if (fd_[c] < 0 && erro == 0) erro = errno;
+        }
+#endif
+        int abertos = 0;
+        for (int c = 0; c < NUM_CONTADORES; ++c) abertos += (fd_[c] >= 0);
+        if (abertos < NUM_CONTADORES)
+            cerr << "contadores de hardware: " << abertos << " de " << NUM_CONTADORES
+                 << " disponiveis (perf_event_open: " << strerror(erro) << ")" << endl;
+    }
+
+public:
+    ContadoresHardware() {}
+    ContadoresHardware(const ContadoresHardware&) = delete;
+    ContadoresHardware& operator=(const ContadoresHardware&) = delete;
+
+    ~ContadoresHardware() {
+#ifdef __linux__
+        if (aberto_)
+            for (int c = 0; c < NUM_CONTADORES; ++c)
+                if (fd_[c] >= 0) close(fd_[c]);
+#endif
+    }
+
+    bool ativo() {
+        if (!aberto_) abrir();
+        for (int c = 0; c < NUM_CONTADORES; ++c)
+            if (fd_[c] >= 0) return true;
+        return false;
+    }
+
+    //INICIAR / PARAR (em volta da regiao do Cronometro)
+    void iniciar() {
+        if (!ativo()) return;
+#ifdef __linux__
+        for (int c = 0; c < NUM_CONTADORES; ++c) {
+            if (fd_[c] < 0) continue;
+            if (!ler(fd_[c], inicio_[c])) inicio_[c][0] = inicio_[c][1] = inicio_[c][2] = 0;
+            ioctl(fd_[c], PERF_EVENT_IOC_ENABLE, 0);
+        }
+        ligado_ = true;
+#endif
+    }
+
+    LeituraContadores parar() {
+        LeituraContadores r;
+        if (!ligado_) return r;
+        ligado_ = false;
+#ifdef __linux__
+        for (int c = 0; c < NUM_CONTADORES; ++c)
+            if (fd_[c] >= 0) ioctl(fd_[c], PERF_EVENT_IOC_DISABLE, 0);
+        for (int c = 0; c < NUM_CONTADORES; ++c) {
+            if (fd_[c] < 0) continue;
+            uint64_t fim[3];
+            if (!ler(fd_[c], fim)) continue;
+            double valor = (double)(fim[0] - inicio_[c][0]);
+            double habilitado = (double)(fim[1] - inicio_[c][1]);
+            double rodando = (double)(fim[2] - inicio_[c][2]);
+            if (rodando > 0 && rodando < habilitado) valor *= habilitado / rodando;
+            r.valor[c] = rodando > 0 ? valor : 0.0;
+        }
+#endif
+        return r;
+    }
+};
+
+inline ContadoresHardware& contadoresHardware() {
+    static ContadoresHardware c;
+    return c;
+}
+
+// Colunas do CSV (media por execucao; -1 = indisponivel)
+inline void escreverColunasContadores(ostream& out, const LeituraContadores& l) {
+    for (int c = 0; c < NUM_CONTADORES; ++c) {
+        if (c) out << ",";
+        if (l.valor[c] < 0) out << -1;
+        else out << (long long)(l.valor[c] + 0.5);
+    }
+}
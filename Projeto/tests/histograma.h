@@ -0,0 +1,150 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+/*
+    -------------
+    [HISTOGRAMA DE LATENCIA]
+    -------------
+    Latencia de cada operacao individual (um set, um getElemento), para ver
+    a cauda que o tempo total do laco esconde: rehash do unordered_map,
+    rebalanceamento da arvore, listas longas em linhas de grau alto.
+
+    Relogio: rdtsc (dezenas de ciclos por leitura), convertido para ns por
+    uma calibracao contra o steady_clock. O custo de um par de leituras
+    vazio e descontado de cada amostra.
+
+    Baldes no estilo HDR: valores < 128 tem balde proprio; acima disso cada
+    potencia de 2 e dividida em 64 baldes, entao o erro relativo de um
+    percentil fica abaixo de 1/64 (~1.6%). O maximo e guardado exato.
+*/
+
+// lfence dos dois lados: a leitura nao e reordenada com a operacao medida
+inline uint64_t lerTSC() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence();
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+#else
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// ns por tick do lerTSC() (calibrado uma vez, ~20 ms)
+inline double nsPorTick() {
+    static const double fator = []() {
+#if defined(__x86_64__) || defined(__i386__)
+        auto t0 = chrono::steady_clock::now();
+        uint64_t c0 = lerTSC();
+        while (chrono::steady_clock::now() - t0 < chrono::milliseconds(20)) {}
+        uint64_t c1 = lerTSC();
+        auto t1 = chrono::steady_clock::now();
+        double ns = (double)chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count();
+        return c1 > c0 ? ns / (double)(c1 - c0) : 1.0;
+#else
+        return 1.0;
+#endif
+    }();
+    return fator;
+}
+
+// Ticks de um par de leituras sem nada no meio (minimo de varias tentativas)
+inline uint64_t custoLeituraTSC() {
+    static const uint64_t custo = []() {
+        uint64_t menor = UINT64_MAX;
+        for (int r = 0; r < 1000; ++r) {
+            uint64_t a = lerTSC();
+            uint64_t b = lerTSC();
+            menor = min(menor, b - a);
+        }
+        return menor;
+    }();
+    return custo;
+}
+
+class HistogramaLatencia {
+private:
+    static const int BITS_LINEAR = 7;                  // 0..127 exatos
+    static const int SUB_BALDES = 1 << (BITS_LINEAR - 1);   // 64 por potencia de 2
+    static const int NUM_BALDES = (1 << BITS_LINEAR) + (64 - BITS_LINEAR) * SUB_BALDES;
+
+    vector<uint64_t> baldes_;
+    uint64_t total_ = 0;
+    uint64_t maximo_ = 0;
+    double soma_ = 0;
+
+    static int indice(uint64_t v) {
+        if (v < (1u << BITS_LINEAR)) return (int)v;
+        int m = 63 - __builtin_clzll(v);                 // bit mais alto, >= BITS_LINEAR
+        int desloc = m - (BITS_LINEAR - 1);
+        int topo = (int)(v >> desloc) - SUB_BALDES;      // em [0, 64)
+        return (1 << BITS_LINEAR) + (m - BITS_LINEAR) * SUB_BALDES + topo;
+    }
+
+    // maior valor que cai no balde b
+    static uint64_t limiteSuperior(int b) {
+        if (b < (1 << BITS_LINEAR)) return (uint64_t)b;
+        int r = b - (1 << BITS_LINEAR);
+        int m = r / SUB_BALDES + BITS_LINEAR;
+        int desloc = m - (BITS_LINEAR - 1);
+        uint64_t topo = (uint64_t)(r % SUB_BALDES + SUB_BALDES);
+        return ((topo + 1) << desloc) - 1;
+    }
+
+public:
+    HistogramaLatencia() : baldes_(NUM_BALDES, 0) {}
+
+    // ticks do lerTSC()
+    void registrar(uint64_t ticks) {
+        ++baldes_[indice(ticks)];
+        ++total_;
+        soma_ += (double)ticks;
+        maximo_ = max(maximo_, ticks);
+    }
+
+    // mede uma chamada de f
+    template <typename F>
+    void medir(F&& f) {
+        uint64_t a = lerTSC();
+        f();
+        uint64_t b = lerTSC();
+        uint64_t d = b - a;
+        uint64_t custo = custoLeituraTSC();
+        registrar(d > custo ? d - custo : 0);
+    }
+
+    void juntar(const HistogramaLatencia& o) {
+        for (int b = 0; b < NUM_BALDES; ++b) baldes_[b] += o.baldes_[b];
+        total_ += o.total_;
+        soma_ += o.soma_;
+        maximo_ = max(maximo_, o.maximo_);
+    }
+
+    uint64_t total() const { return total_; }
+
+    // percentil p em [0, 100], em ns (limite superior do balde)
+    double percentilNs(double p) const {
+        if (total_ == 0) return -1;
+        uint64_t alvo = (uint64_t)ceil(p / 100.0 * (double)total_);
+        alvo = max<uint64_t>(1, min(alvo, total_));
+        uint64_t acumulado = 0;
+        for (int b = 0; b < NUM_BALDES; ++b) {
+            acumulado += baldes_[b];
+            if (acumulado >= alvo) return (double)min(limiteSuperior(b), maximo_) * nsPorTick();
+        }
+        return (double)maximo_ * nsPorTick();
+    }
+
+    double maximoNs() const { return total_ ? (double)maximo_ * nsPorTick() : -1; }
+    double mediaNs() const { return total_ ? soma_ / (double)total_ * nsPorTick() : -1; }
+};
@@ -0,0 +1,285 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <ctime>
+#include <cstdio>
+#include <cstdint>
+#include <utility>
+#include "benchmark.h"
+#include "histograma.h"
+#include "../alocacao.h"
+#ifdef __linux__
+#include <sys/utsname.h>
+#endif
+
+using namespace std;
+
+/*
+    -------------
+    [RELATORIO DOS BENCHMARKS]
+    -------------
+    Uma linha por (operacao, estrutura, ponto) em CSV ou JSON, mais o
+    ambiente da execucao (CPU, compilador, flags, commit, linha de comando)
+    para comparar rodadas de maquinas diferentes.
+
+    CSV: o ambiente vai em linhas "# chave: valor" antes do cabecalho
+    (pandas: read_csv(..., comment='#')). As colunas antigas continuam na
+    frente e com o mesmo nome, entao os scripts de analise leem os dois.
+    JSON: {"ambiente": {...}, "resultados": [{...}, ...]}.
+    Amostras_ns guarda o tempo por execucao de cada amostra (separados por
+    ';'), que e o que a comparacao com um baseline usa (comparacao.h).
+    Escala/Eficiencia sao da varredura de threads: forte = T1 / (p * Tp),
+    fraca = T1 / Tp (o problema cresce com p).
+
+    O commit e as flags vem do Makefile (-DMC458_GIT, -DMC458_FLAGS);
+    compilando na mao o commit e lido do git em tempo de execucao.
+*/
+
+struct Resultado {
+    string operacao;
+    string estrutura;
+    long long tamanho = 0;      // valor da coluna N (ou k, nos testes em funcao de k)
+    double esparsidade = 0;
+    long long dimensao = 0;
+    long long naoNulos = 0;     // entradas geradas para cada operando
+    string carga;
+    int threads = 1;
+    uint64_t semente = 0;
+    Medicao tempo;
+    long long memoria = 0;
+    double latencia[4] = {-1, -1, -1, -1};   // p50, p99, p99.9 e maximo (SET/GET)
+    string escala = "forte";    // forte: problema fixo; fraca: problema cresce com as threads
+    double eficiencia = -1;     // em relacao a 1 thread no mesmo ponto (-1 = sem referencia)
+
+    void definirLatencias(const HistogramaLatencia& h) {
+        if (h.total() == 0) return;
+        latencia[0] = h.percentilNs(50);
+        latencia[1] = h.percentilNs(99);
+        latencia[2] = h.percentilNs(99.9);
+        latencia[3] = h.maximoNs();
+    }
+};
+
+//AMBIENTE
+typedef vector<pair<string, string>> Ambiente;
+
+inline string lerComando(const string& comando) {
+    string saida;
+    if (FILE* p = popen(comando.c_str(), "r")) {
+        char buf[256];
+        while (fgets(buf, sizeof(buf), p)) saida += buf;
+        pclose(p);
+    }
+    while (!saida.empty() && (saida.back() == '\n' || saida.back() == '\r')) saida.pop_back();
+    return saida;
+}
+
+inline string modeloCPU() {
+    ifstream f("/proc/cpuinfo");
+    string linha;
+    while (getline(f, linha)) {
+        if (linha.compare(0, 10, "model name") != 0) continue;
+        size_t p = linha.find(':');
+        if (p == string::npos) break;
+        p = linha.find_first_not_of(" \t", p + 1);
+        return p == string::npos ? "" : linha.substr(p);
+    }
+    return "desconhecido";
+}
+
+inline string versaoCompilador() {
+#if defined(__clang__)
+    return string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    return string("gcc ") + __VERSION__;
+#else
+    return "desconhecido";
+#endif
+}
+
+inline string commitGit() {
+#ifdef MC458_GIT
+    return MC458_GIT;
+#else
+    string s = lerComando("git describe --always --dirty 2>/dev/null");
+    return s.empty() ? "desconhecido" : s;
+#endif
+}
+
+inline string flagsCompilacao() {
+#ifdef MC458_FLAGS
+    return MC458_FLAGS;
+#elif defined(__OPTIMIZE__)
+    return "desconhecido (otimizado)";
+#else
+    return "desconhecido (sem otimizacao)";
+#endif
+}
+
+inline Ambiente coletarAmbiente(int argc, char** argv) {
+    Ambiente a;
+    char data[64];
+    time_t agora = time(nullptr);
+    strftime(data, sizeof(data), "%Y-%m-%dT%H:%M:%SZ", gmtime(&agora));
+    a.push_back({"data", data});
+    a.push_back({"cpu", modeloCPU()});
+    a.push_back({"nucleos", to_string(thread::hardware_concurrency())});
+#ifdef __linux__
+    utsname u;
+    if (uname(&u) == 0) {
+        a.push_back({"sistema", string(u.sysname) + " " + u.release + " " + u.machine});
+        a.push_back({"host", u.nodename});
+    }
+#endif
+    a.push_back({"compilador", versaoCompilador()});
+    a.push_back({"flags", flagsCompilacao()});
+    a.push_back({"git", commitGit()});
+    string comando;
+    for (int i = 0; i < argc; ++i) comando += (i ? " " : "") + string(argv[i]);
+    a.push_back({"comando", comando});
+    a.push_back({"amostras", to_string(opcoesMedicao().amostras)});
+    a.push_back({"tempo_max_ms", to_string(opcoesMedicao().tempoMaximo_ns / 1000000)});
+    a.push_back({"contadores", contadoresHardware().ativo() ? "sim" : "nao"});
+    const char* cpu = getenv("MC458_CPU");
+    a.push_back({"cpu_fixada", cpu ? cpu : "nao"});
+    a.push_back({"alocacao", nomePaginas(politicaAlocacao().paginas) + "," + nomeNuma(politicaAlocacao().numa)});
+    return a;
+}
+
+//SAIDA
+inline vector<string> separar(const string& s, char sep) {
+    vector<string> partes;
+    string atual;
+    for (char c : s) {
+        if (c == sep) { partes.push_back(atual); atual.clear(); }
+        else atual += c;
+    }
+    partes.push_back(atual);
+    return partes;
+}
+
+inline string juntarAmostras(const vector<double>& t, const char* sep) {
+    string r;
+    for (size_t i = 0; i < t.size(); ++i) r += (i ? sep : "") + formatarNs(t[i]);
+    return r;
+}
+
+inline string escaparJSON(const string& s) {
+    string r;
+    for (char c : s) {
+        if (c == '"' || c == '\\') { r += '\\'; r += c; }
+        else if (c == '\n') r += "\\n";
+        else if ((unsigned char)c < 0x20) r += ' ';
+        else r += c;
+    }
+    return r;
+}
+
+class Relatorio {
+private:
+    ostream* out_ = &cout;
+    ofstream arquivo_;
+    bool json_ = false;
+    bool primeira_ = true;
+    string colunaTamanho_ = "N";
+    vector<Resultado> resultados_;
+
+    void linhaCSV(const Resultado& r) {
+        ostream& o = *out_;
+        o << r.operacao << ","
+          << r.estrutura << ","
+          << r.tamanho << ","
+          << r.esparsidade << ","
+          << tempoCSV(r.tempo) << ","
+          << r.memoria << ","
+          << r.carga << ",";
+        escreverColunasMedicao(o, r.tempo);
+        for (double l : r.latencia) o << "," << (l < 0 ? string("-1") : formatarNs(l));
+        o << "," << r.dimensao << "," << r.naoNulos << "," << r.threads << "," << r.semente
+          << "," << r.escala << "," << (r.eficiencia < 0 ? string("-1") : to_string(r.eficiencia))
+          << "," << juntarAmostras(r.tempo.tempos, ";") << "\n";
+        o.flush();
+    }
+
+    void objetoJSON(const Resultado& r) {
+        ostream& o = *out_;
+        const Medicao& m = r.tempo;
+        o << (primeira_ ? "\n" : ",\n") << "    {"
+          << "\"operacao\": \"" << escaparJSON(r.operacao) << "\", "
+          << "\"estrutura\": \"" << escaparJSON(r.estrutura) << "\", "
+          << "\"" << colunaTamanho_ << "\": " << r.tamanho << ", "
+          << "\"dimensao\": " << r.dimensao << ", "
+          << "\"nao_nulos\": " << r.naoNulos << ", "
+          << "\"esparsidade\": " << r.esparsidade << ", "
+          << "\"carga\": \"" << escaparJSON(r.carga) << "\", "
+          << "\"threads\": " << r.threads << ", "
+          << "\"semente\": " << r.semente << ", "
+          << "\"escala\": \"" << r.escala << "\", "
+          << "\"eficiencia\": " << (r.eficiencia < 0 ? string("-1") : to_string(r.eficiencia)) << ", "
+          << "\"tempo_ns\": " << tempoCSV(m) << ", "
+          << "\"memoria_bytes\": " << r.memoria << ", "
+          << "\"media_ns\": " << (m.valida() ? formatarNs(m.media_ns) : "-1") << ", "
+          << "\"desvio_ns\": " << (m.valida() ? formatarNs(m.desvio_ns) : "-1") << ", "
+          << "\"ic95\": [" << (m.valida() ? formatarNs(m.icInferior_ns) : "-1") << ", "
+          << (m.valida() ? formatarNs(m.icSuperior_ns) : "-1") << "], "
+          << "\"amostras\": " << m.amostras << ", "
+          << "\"iteracoes\": " << m.iteracoes << ", "
+          << "\"descartadas\": " << m.descartadas << ", "
+          << "\"contadores\": [";
+        for (int c = 0; c < NUM_CONTADORES; ++c)
+            o << (c ? ", " : "") << (m.contadores.valor[c] < 0 ? -1LL : (long long)(m.contadores.valor[c] + 0.5));
+        o << "], \"latencia_ns\": [";
+        for (int q = 0; q < 4; ++q)
+            o << (q ? ", " : "") << (r.latencia[q] < 0 ? string("-1") : formatarNs(r.latencia[q]));
+        o << "], \"amostras_ns\": [" << juntarAmostras(m.tempos, ", ") << "]}";
+        o.flush();
+        primeira_ = false;
+    }
+
+public:
+    // formato "csv" ou "json"; caminho vazio = saida padrao
+    bool abrir(const string& formato, const string& caminho, const Ambiente& ambiente, const string& colunaTamanho) {
+        json_ = formato == "json";
+        colunaTamanho_ = colunaTamanho;
+        if (!caminho.empty()) {
+            arquivo_.open(caminho);
+            if (!arquivo_) {
+                cerr << "nao foi possivel abrir " << caminho << endl;
+                return false;
+            }
+            out_ = &arquivo_;
+        }
+        ostream& o = *out_;
+        if (json_) {
+            o << "{\n  \"ambiente\": {";
+            for (size_t i = 0; i < ambiente.size(); ++i)
+                o << (i ? ", " : "") << "\n    \"" << ambiente[i].first << "\": \"" << escaparJSON(ambiente[i].second) << "\"";
+            o << "\n  },\n  \"resultados\": [";
+        } else {
+            for (auto& a : ambiente) o << "# " << a.first << ": " << a.second << "\n";
+            o << "Operacao,Estrutura," << colunaTamanho_ << ",Esparsidade,Tempo_ns,Memoria_Bytes,Carga,"
+              << colunasMedicao() << ",Lat_P50_ns,Lat_P99_ns,Lat_P999_ns,Lat_Max_ns,Dimensao,NaoNulos,Threads,Semente,Escala,Eficiencia,Amostras_ns\n";
+        }
+        o.flush();
+        return true;
+    }
+
+    void escrever(const Resultado& r) {
+        if (json_) objetoJSON(r);
+        else linhaCSV(r);
+        resultados_.push_back(r);
+    }
+
+    const vector<Resultado>& resultados() const { return resultados_; }
+    const string& colunaTamanho() const { return colunaTamanho_; }
+
+    void fechar() {
+        if (json_) *out_ << "\n  ]\n}\n";
+        out_->flush();
+        if (arquivo_.is_open()) arquivo_.close();
+    }
+};
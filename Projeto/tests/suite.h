@@ -0,0 +1,863 @@
+#pragma once
+#include "../densa.h"
+#include "../estrutura_um.h" // Hash
+#include "../estrutura_dois.h" // Tree
+#include "../mistas.h"
+#include "../camadas.h" // delta + CSR
+#include "../fragmentada.h" // Hash dividida por linhas
+#include "../gerador.h"
+#include "util_medicao.h"
+#include "benchmark.h"
+#include "histograma.h"
+#include "relatorio.h"
+#include "comparacao.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include <map>
+#include <thread>
+
+using namespace std;
+
+/*
+    -------------
+    [SUITE DE BENCHMARKS]
+    -------------
+    Os testes de operacoes, de construcao e em funcao de k num lugar so.
+    A linha de comando escolhe operacoes, estruturas, dimensoes,
+    esparsidades ou k, threads, sementes, amostras e cargas; os tres
+    testes antigos viraram presets (mesmos parametros de antes).
+
+    Para cada semente, carga e numero de threads a sequencia de sementes e
+    reiniciada, entao rodadas com threads diferentes medem as mesmas
+    matrizes. Cada operacao gera os proprios operandos (como antes).
+
+    Com --baseline=ARQ a rodada e comparada com um CSV de referencia no fim
+    (comparacao.h) e o executavel sai com 3 se algum ponto ficou mais lento
+    que o limiar com significancia; --comparar=ARQ compara um CSV ja
+    gravado sem rodar nada.
+
+    Escalabilidade: com --threads=1,2,4,... cada linha sai com a eficiencia
+    em relacao a 1 thread no mesmo ponto. --escala=forte mantem o problema
+    (T1 / (p * Tp)); --escala=fraca multiplica k (ou a esparsidade) por p e
+    a dimensao do GEMM por cbrt(p), o trabalho por thread fica constante
+    (T1 / Tp). SPMV e GEMM existem para isso: sao os kernels paralelos.
+    O preset "fragmentos" compara a Hash com a HashFrag (fragmentada.h),
+    que tem um fragmento de linhas por thread: CONSTRUCAO e SOMA deixam de
+    ser sequenciais e a eficiencia mostra quanto escalam.
+
+    Listas: "a,b,c"; intervalos "ini:fim" (passo 1), "ini:fim:passo" ou
+    "ini:fim:xFator" (geometrico). Ex.: --dims=1e2:1e6:x10 --k=1:200:10
+*/
+
+enum class Estrutura { DENSA, HASH, TREE, CSR, CAMADAS, FRAGMENTADA };
+
+// Nomes do CSV: os testes por N usam os nomes do relatorio do projeto,
+// os testes em funcao de k os curtos
+inline string nomeEstrutura(Estrutura e, bool curto) {
+    switch (e) {
+        case Estrutura::DENSA: return "Densa";
+        case Estrutura::HASH: return curto ? "Hash" : "Est1(Hash)";
+        case Estrutura::TREE: return curto ? "Tree" : "Est2(Tree)";
+        case Estrutura::CAMADAS: return "Camadas";
+        case Estrutura::FRAGMENTADA: return "HashFrag";
+        default: return "CSR";
+    }
+}
+
+inline string emMaiusculas(string s) {
+    for (char& c : s) c = (char)toupper((unsigned char)c);
+    return s;
+}
+
+inline bool estruturaPorNome(const string& nome, Estrutura& e) {
+    string n = emMaiusculas(nome);
+    if (n == "DENSA") e = Estrutura::DENSA;
+    else if (n == "HASH" || n == "EST1" || n == "EST1(HASH)") e = Estrutura::HASH;
+    else if (n == "TREE" || n == "EST2" || n == "EST2(TREE)") e = Estrutura::TREE;
+    else if (n == "CSR") e = Estrutura::CSR;
+    else if (n == "CAMADAS" || n == "LSM") e = Estrutura::CAMADAS;
+    else if (n == "HASHFRAG" || n == "FRAGMENTADA" || n == "FRAG") e = Estrutura::FRAGMENTADA;
+    else return false;
+    return true;
+}
+
+inline const vector<string>& todasOperacoes() {
+    static const vector<string> ops = {"CONSTRUCAO", "SET", "GET", "TRANS", "TRANS_EXPL", "SOMA", "MULT", "ESCALAR", "SPMV", "GEMM", "HADAMARD", "SPMM"};
+    return ops;
+}
+
+struct ConfigSuite {
+    vector<string> ops = todasOperacoes();          // na ordem de execucao
+    vector<Estrutura> estruturas = {Estrutura::DENSA, Estrutura::HASH, Estrutura::TREE, Estrutura::CSR};
+    vector<long long> dims = {100, 1000, 10000, 100000};
+    vector<double> esparsidades;                    // vazio = regra do projeto
+    vector<long long> ks;                           // nao vazio: pontos por k em vez de esparsidade
+    vector<int> threads;                            // vazio = o que ja estava configurado
+    vector<uint64_t> sementes = {458};
+    vector<TipoCarga> cargas = {TipoCarga::UNIFORME};
+    long long limiteDensa = 10000;                  // evita estouro de RAM/tempo
+    long long limiteDensaMult = 1000;
+    string escala = "forte";                        // forte | fraca
+    long long dimGemm = 512;                        // GEMM denso (sempre completo)
+    string formato = "csv";
+    string saida;                                   // vazio = saida padrao
+    string baseline;                                // CSV de referencia
+    string comparar;                                // CSV a comparar sem rodar
+    string saidaComparacao;                         // vazio = stderr (stdout com --comparar)
+    OpcoesComparacao comparacao;
+};
+
+// Esparsidades do enunciado para uma dimensao (10^i: i < 4 fixas, senao
+// 10^-(i+2), 10^-(i+1) e 10^-i dividido por 100)
+inline vector<double> esparsidadesDoProjeto(long long dimensao) {
+    if (dimensao < 10000) return {0.01, 0.05, 0.10, 0.20};
+    double d = (double)dimensao;
+    return {(1.0 / (d * 100)) / 100.0, (1.0 / (d * 10)) / 100.0, (1.0 / d) / 100.0};
+}
+
+//PRESETS
+// Parametros dos tres testes antigos
+inline bool aplicarPreset(const string& nome, ConfigSuite& c) {
+    if (nome == "operacoes") {
+        c.ops = {"TRANS", "TRANS_EXPL", "SOMA", "MULT", "ESCALAR", "SET", "GET"};
+        c.estruturas = {Estrutura::DENSA, Estrutura::HASH, Estrutura::TREE, Estrutura::CSR};
+        c.dims.clear();
+        for (long long d = 100; d <= 100000000LL; d *= 10) c.dims.push_back(d);
+        c.esparsidades.clear();
+        c.ks.clear();
+    } else if (nome == "construcao") {
+        aplicarPreset("operacoes", c);
+        c.ops = {"CONSTRUCAO"};
+    } else if (nome == "funcao_de_k") {
+        c.ops = {"SOMA", "MULT", "TRANS", "ESCALAR", "SET", "GET"};
+        c.estruturas = {Estrutura::HASH, Estrutura::TREE};
+        c.dims = {20000};
+        c.esparsidades.clear();
+        c.ks.clear();
+        for (long long x = 1; x <= 200; x++) c.ks.push_back(x);             // ultra denso
+        for (long long x = 201; x <= 1000; x += 10) c.ks.push_back(x);      // super denso
+        for (long long x = 2010; x <= 10000; x += 100) c.ks.push_back(x);   // moderado
+        for (long long x = 10100; x <= 40000; x += 1000) c.ks.push_back(x); // medio
+        for (long long x = 41000; x <= 200000; x += 10000) c.ks.push_back(x); // grande
+    } else if (nome == "escalabilidade") {
+        c.ops = {"CONSTRUCAO", "SOMA", "MULT", "SPMV", "GEMM"};
+        c.estruturas = {Estrutura::HASH, Estrutura::TREE, Estrutura::CSR};
+        c.dims = {100000};
+        c.esparsidades.clear();
+        c.ks = {100000};
+        // 1, 2, 4, ... ate o numero de nucleos (que entra mesmo sem ser potencia de 2)
+        int nucleos = max(1, (int)thread::hardware_concurrency());
+        c.threads.clear();
+        for (int t = 1; t < nucleos; t *= 2) c.threads.push_back(t);
+        c.threads.push_back(nucleos);
+    } else if (nome == "fragmentos") {
+        // Hash sequencial contra a fragmentada (um fragmento por thread)
+        aplicarPreset("escalabilidade", c);
+        c.ops = {"CONSTRUCAO", "SOMA", "MULT", "SPMV"};
+        c.estruturas = {Estrutura::HASH, Estrutura::FRAGMENTADA};
+        c.ks = {1000000};
+    } else {
+        return false;
+    }
+    return true;
+}
+
+//LINHA DE COMANDO
+inline bool lerNumero(const string& s, double& v) {
+    char* fim = nullptr;
+    v = strtod(s.c_str(), &fim);
+    return !s.empty() && fim && *fim == '\0';
+}
+
+// "a,b,ini:fim[:passo|:xFator]"
+inline bool lerLista(const string& s, vector<double>& saida) {
+    saida.clear();
+    for (const string& item : separar(s, ',')) {
+        vector<string> p = separar(item, ':');
+        double a, b, passo = 1;
+        if (p.size() == 1) {
+            if (!lerNumero(p[0], a)) return false;
+            saida.push_back(a);
+            continue;
+        }
+        if (p.size() > 3 || !lerNumero(p[0], a) || !lerNumero(p[1], b)) return false;
+        bool geometrico = p.size() == 3 && !p[2].empty() && (p[2][0] == 'x' || p[2][0] == 'X');
+        if (p.size() == 3 && !lerNumero(geometrico ? p[2].substr(1) : p[2], passo)) return false;
+        if (geometrico ? passo <= 1 || a <= 0 : passo <= 0) return false;
+        for (double x = a; x <= b * (1 + 1e-12); x = geometrico ? x * passo : x + passo) saida.push_back(x);
+    }
+    return !saida.empty();
+}
+
+template <typename T>
+bool lerListaInteiros(const string& s, vector<T>& saida) {
+    vector<double> v;
+    if (!lerLista(s, v)) return false;
+    saida.clear();
+    for (double x : v) saida.push_back((T)llround(x));
+    return true;
+}
+
+inline void imprimirUso(const char* programa) {
+    cerr << "uso: " << programa << " [opcoes] [cargas...]\n"
+         << "  --preset=operacoes|construcao|funcao_de_k|escalabilidade|fragmentos\n"
+         << "  --ops=CONSTRUCAO,SET,GET,TRANS,TRANS_EXPL,SOMA,MULT,ESCALAR,SPMV,GEMM,HADAMARD,SPMM|todas\n"
+         << "  --estruturas=densa,hash,tree,csr,camadas,hashfrag\n"
+         << "                            (camadas: delta + CSR; hashfrag: Hash em um fragmento\n"
+         << "                             de linhas por thread; as duas so quando pedidas)\n"
+         << "  --dims=LISTA              dimensoes (ex.: 1e2:1e6:x10)\n"
+         << "  --esp=LISTA|auto          esparsidades (auto = regra do projeto)\n"
+         << "  --k=LISTA                 nao nulos por operando (no lugar de --esp)\n"
+         << "  --threads=LISTA           threads dos kernels (0 = todos os nucleos)\n"
+         << "  --escala=forte|fraca      fraca: k e dimensao do GEMM crescem com as threads\n"
+         << "  --dim-gemm=n              dimensao do GEMM denso (padrao 512)\n"
+         << "  --sementes=LISTA          sementes base\n"
+         << "  --amostras=n              repeticoes por medicao (MC458_AMOSTRAS)\n"
+         << "  --tempo-max-ms=n          teto de tempo por medicao (MC458_TEMPO_MAX_MS)\n"
+         << "  --cargas=uniforme,banda,bloco_diagonal,zipf,rmat|todas\n"
+         << "  --limite-densa=n --limite-densa-mult=n\n"
+         << "  --paginas=nenhuma|thp|hugetlb   paginas grandes na densa e nos pools (MC458_PAGINAS)\n"
+         << "  --numa=padrao|intercalada|primeiro_toque   posicao das paginas (MC458_NUMA)\n"
+         << "  --formato=csv|json --saida=ARQUIVO\n"
+         << "  --baseline=CSV            compara com uma rodada de referencia (sai com 3 se piorou)\n"
+         << "  --comparar=CSV            so compara este CSV com o --baseline, sem rodar\n"
+         << "  --limiar=f --alfa=f       piora minima (0.05 = 5%) e nivel do teste\n"
+         << "  --saida-comparacao=ARQUIVO\n"
+         << "LISTA: a,b,c | ini:fim | ini:fim:passo | ini:fim:xFator\n";
+}
+
+// Le as opcoes sobre c (que ja vem com os padroes do executavel).
+// Argumentos sem "--" sao cargas, como na linha de comando antiga.
+inline bool lerLinhaDeComando(int argc, char** argv, ConfigSuite& c) {
+    vector<pair<string, string>> opcoes;
+    vector<TipoCarga> cargas;
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg.compare(0, 2, "--") != 0) {
+            TipoCarga t;
+            if (arg == "todas") { vector<TipoCarga> todas = todasCargas(); cargas.insert(cargas.end(), todas.begin(), todas.end()); }
+            else if (cargaPorNome(arg, t)) cargas.push_back(t);
+            else { cerr << "carga desconhecida: " << arg << endl; return false; }
+            continue;
+        }
+        size_t igual = arg.find('=');
+        string chave = arg.substr(2, igual == string::npos ? string::npos : igual - 2);
+        string valor;
+        if (igual != string::npos) valor = arg.substr(igual + 1);
+        else if (chave != "ajuda" && a + 1 < argc) valor = argv[++a];
+        opcoes.push_back({chave, valor});
+    }
+
+    // o preset vem primeiro, as outras opcoes mudam o que ele definiu
+    for (auto& o : opcoes) {
+        if (o.first == "preset" && !aplicarPreset(o.second, c)) {
+            cerr << "preset desconhecido: " << o.second << endl;
+            return false;
+        }
+    }
+
+    for (auto& o : opcoes) {
+        const string& k = o.first;
+        const string& v = o.second;
+        bool ok = true;
+        if (k == "preset") continue;
+        else if (k == "ajuda") { imprimirUso(argv[0]); exit(0); }
+        else if (k == "ops") {
+            c.ops.clear();
+            for (const string& op : separar(v, ',')) {
+                string n = emMaiusculas(op);
+                if (n == "TODAS") { c.ops = todasOperacoes(); break; }
+                if (find(todasOperacoes().begin(), todasOperacoes().end(), n) == todasOperacoes().end()) ok = false;
+                else c.ops.push_back(n);
+            }
+        } else if (k == "estruturas") {
+            c.estruturas.clear();
+            for (const string& nome : separar(v, ',')) {
+                Estrutura e;
+                if (estruturaPorNome(nome, e)) c.estruturas.push_back(e);
+                else ok = false;
+            }
+        } else if (k == "dims") ok = lerListaInteiros(v, c.dims);
+        else if (k == "esp") {
+            c.ks.clear();
+            if (v == "auto") c.esparsidades.clear();
+            else ok = lerLista(v, c.esparsidades);
+        } else if (k == "k") {
+            c.esparsidades.clear();
+            ok = lerListaInteiros(v, c.ks);
+        } else if (k == "threads") ok = lerListaInteiros(v, c.threads);
+        else if (k == "sementes") ok = lerListaInteiros(v, c.sementes);
+        else if (k == "amostras" || k == "repeticoes") {
+            vector<int> n;
+            ok = lerListaInteiros(v, n) && n.size() == 1 && n[0] > 0;
+            if (ok) opcoesMedicao().amostras = n[0];
+        } else if (k == "tempo-max-ms") {
+            vector<long long> n;
+            ok = lerListaInteiros(v, n) && n.size() == 1 && n[0] > 0;
+            if (ok) opcoesMedicao().tempoMaximo_ns = n[0] * 1000000LL;
+        } else if (k == "cargas") {
+            for (const string& nome : separar(v, ',')) {
+                TipoCarga t;
+                if (nome == "todas") { vector<TipoCarga> todas = todasCargas(); cargas.insert(cargas.end(), todas.begin(), todas.end()); }
+                else if (cargaPorNome(nome, t)) cargas.push_back(t);
+                else ok = false;
+            }
+        } else if (k == "limite-densa" || k == "limite-densa-mult") {
+            vector<long long> n;
+            ok = lerListaInteiros(v, n) && n.size() == 1;
+            if (ok) (k == "limite-densa" ? c.limiteDensa : c.limiteDensaMult) = n[0];
+        }
+        else if (k == "escala") { c.escala = v; ok = v == "forte" || v == "fraca"; }
+        else if (k == "dim-gemm") {
+            vector<long long> n;
+            ok = lerListaInteiros(v, n) && n.size() == 1 && n[0] > 0;
+            if (ok) c.dimGemm = n[0];
+        }
+        else if (k == "paginas") ok = paginasPorNome(v, politicaAlocacao().paginas);
+        else if (k == "numa") ok = numaPorNome(v, politicaAlocacao().numa);
+        else if (k == "formato") { c.formato = v; ok = v == "csv" || v == "json"; }
+        else if (k == "saida") c.saida = v;
+        else if (k == "baseline") c.baseline = v;
+        else if (k == "comparar") c.comparar = v;
+        else if (k == "saida-comparacao") c.saidaComparacao = v;
+        else if (k == "limiar") ok = lerNumero(v, c.comparacao.limiar) && c.comparacao.limiar >= 0;
+        else if (k == "alfa") ok = lerNumero(v, c.comparacao.alfa) && c.comparacao.alfa > 0 && c.comparacao.alfa < 1;
+        else { cerr << "opcao desconhecida: --" << k << endl; imprimirUso(argv[0]); return false; }
+
+        if (!ok) {
+            cerr << "valor invalido em --" << k << ": " << v << endl;
+            return false;
+        }
+    }
+    if (!cargas.empty()) c.cargas = cargas;
+    if (!c.comparar.empty() && c.baseline.empty()) {
+        cerr << "--comparar precisa de --baseline" << endl;
+        return false;
+    }
+    return true;
+}
+
+//EXECUCAO
+// Um ponto da varredura (dimensao + esparsidade ou k) e o que vai em toda
+// linha do relatorio
+struct PontoSuite {
+    long long dimensao;
+    long long k;                // pedido; as entradas geradas podem ser menos (capacidade da carga)
+    double esparsidade;
+    bool porK;                  // coluna de tamanho = k e nomes curtos
+    uint64_t semente;
+    string chaveBase;           // o mesmo ponto em qualquer numero de threads (escala fraca: antes de crescer)
+};
+
+class SuiteBenchmark {
+private:
+    const ConfigSuite& c_;
+    Relatorio& rel_;
+    PontoSuite p_;
+    map<string, double> tempo1_;    // mediana com 1 thread, por operacao/estrutura/ponto
+
+    bool usa(Estrutura e) const {
+        return find(c_.estruturas.begin(), c_.estruturas.end(), e) != c_.estruturas.end();
+    }
+
+    bool usaOp(const string& op) const {
+        return find(c_.ops.begin(), c_.ops.end(), op) != c_.ops.end();
+    }
+
+    vector<Entry> gerar() {
+        return gerar_matriz_esparsa_k(p_.dimensao, p_.k);
+    }
+
+    void emitir(const string& op, Estrutura e, const Medicao& t, long long mem, size_t nnz,
+                const HistogramaLatencia* lat = nullptr) {
+        Resultado r;
+        r.operacao = op;
+        r.estrutura = nomeEstrutura(e, p_.porK);
+        r.tamanho = p_.porK ? p_.k : p_.dimensao;
+        r.esparsidade = p_.esparsidade;
+        r.dimensao = p_.dimensao;
+        r.naoNulos = (long long)nnz;
+        r.carga = nomeCarga(cargaAtual());
+        r.threads = numThreads();
+        r.semente = p_.semente;
+        r.tempo = t;
+        r.memoria = mem;
+        if (lat) r.definirLatencias(*lat);
+        r.escala = c_.escala;
+        if (t.valida() && t.mediana_ns > 0) {
+            string chave = op + "|" + r.estrutura + "|" + p_.chaveBase;
+            if (r.threads == 1) tempo1_[chave] = t.mediana_ns;
+            auto it = tempo1_.find(chave);
+            if (it != tempo1_.end())
+                r.eficiencia = it->second / t.mediana_ns / (c_.escala == "fraca" ? 1.0 : (double)r.threads);
+        }
+        rel_.escrever(r);
+    }
+
+    template <typename Matriz>
+    Matriz montar(const vector<Entry>& base) {
+        Matriz A(p_.dimensao, p_.dimensao);
+        for (auto& e : base) A.set(e.i, e.j, e.valor);
+        return A;
+    }
+
+    // Estruturas na ordem do relatorio; a densa acima do limite sai com -1
+    template <typename F>
+    void paraCadaEstrutura(const string& op, size_t nnz, long long limiteDensa, F medirEstrutura) {
+        for (Estrutura e : {Estrutura::DENSA, Estrutura::HASH, Estrutura::TREE, Estrutura::CSR, Estrutura::CAMADAS,
+                            Estrutura::FRAGMENTADA}) {
+            if (!usa(e)) continue;
+            Medicao t;
+            long long mem = 0;
+            if (e == Estrutura::DENSA && p_.dimensao > limiteDensa) {
+                emitir(op, e, t, mem, nnz);
+                continue;
+            }
+            if (medirEstrutura(e, t, mem)) emitir(op, e, t, mem, nnz);
+        }
+    }
+
+    //CONSTRUCAO
+    // Tempo e memoria de construtor + insercoes. A matriz da amostra
+    // anterior e destruida fora do relogio.
+    template <typename Matriz>
+    Medicao medirConstrucao(const vector<Entry>& base, long long& mem) {
+        unique_ptr<Matriz> M;
+        return medirComPreparo(
+            [&]() { M.reset(); },
+            [&]() {
+                M.reset(new Matriz(p_.dimensao, p_.dimensao));
+                for (auto& e : base) M->set(e.i, e.j, e.valor);
+            },
+            &mem);
+    }
+
+    // Fragmentada: insercao em bloco, uma thread por fragmento
+    Medicao medirConstrucaoFragmentada(const vector<Entry>& base, long long& mem) {
+        unique_ptr<MatrizEsparsaHashFragmentada> M;
+        return medirComPreparo(
+            [&]() { M.reset(); },
+            [&]() {
+                M.reset(new MatrizEsparsaHashFragmentada(p_.dimensao, p_.dimensao));
+                M->inserirEmParalelo(base);
+            },
+            &mem);
+    }
+
+    void construcao() {
+        vector<Entry> base = gerar();
+        paraCadaEstrutura("CONSTRUCAO", base.size(), c_.limiteDensa, [&](Estrutura e, Medicao& t, long long& mem) {
+            if (e == Estrutura::DENSA) t = medirConstrucao<MatrizDensa>(base, mem);
+            else if (e == Estrutura::HASH) t = medirConstrucao<MatrizEsparsaHashDup>(base, mem);
+            else if (e == Estrutura::TREE) t = medirConstrucao<MatrizEsparsaTreeDup>(base, mem);
+            else if (e == Estrutura::CAMADAS) t = medirConstrucao<MatrizEmCamadas>(base, mem);
+            else if (e == Estrutura::FRAGMENTADA) t = medirConstrucaoFragmentada(base, mem);
+            else return false;
+            return true;
+        });
+    }
+
+    //INSERCAO E CONSULTA
+    // SET: cada amostra insere tudo numa matriz nova (criada fora do relogio).
+    // A memoria do SET e a da matriz montada (construtor + insercoes), medida
+    // na copia que depois serve para o GET. Essa copia e montada e consultada
+    // operacao a operacao para os histogramas de latencia.
+    template <typename Matriz>
+    void medirInsercaoConsulta(const vector<Entry>& base, Medicao& t_set, long long& m_set, Medicao& t_get,
+                               HistogramaLatencia& lat_set, HistogramaLatencia& lat_get) {
+        long long dim = p_.dimensao;
+        unique_ptr<Matriz> nova;
+        t_set = medirComPreparo(
+            [&]() { nova.reset(); nova.reset(new Matriz(dim, dim)); },
+            [&]() { for (auto& e : base) nova->set(e.i, e.j, e.valor); });
+        nova.reset();
+
+        start_tracking();
+        Matriz A(dim, dim);
+        for (auto& e : base) lat_set.medir([&]() { A.set(e.i, e.j, e.valor); });
+        m_set = get_tracked_bytes();
+        stop_tracking();
+
+        t_get = medir([&]() {
+            for (auto& e : base) {
+                double v = A.getElemento(e.i, e.j);
+                naoOtimizar(v);
+            }
+        });
+
+        for (auto& e : base) {
+            lat_get.medir([&]() {
+                double v = A.getElemento(e.i, e.j);
+                naoOtimizar(v);
+            });
+        }
+    }
+
+    void insercaoConsulta() {
+        vector<Entry> base = gerar();
+        if (base.empty()) return;
+
+        struct Linha { Estrutura e; Medicao t_set, t_get; long long m_set = 0; HistogramaLatencia l_set, l_get; };
+        vector<unique_ptr<Linha>> linhas;
+        for (Estrutura e : {Estrutura::DENSA, Estrutura::HASH, Estrutura::TREE, Estrutura::CAMADAS, Estrutura::FRAGMENTADA}) {
+            if (!usa(e)) continue;
+            linhas.emplace_back(new Linha());
+            Linha& l = *linhas.back();
+            l.e = e;
+            if (e == Estrutura::DENSA && p_.dimensao > c_.limiteDensa) continue;
+            if (e == Estrutura::DENSA)
+                medirInsercaoConsulta<MatrizDensa>(base, l.t_set, l.m_set, l.t_get, l.l_set, l.l_get);
+            else if (e == Estrutura::HASH)
+                medirInsercaoConsulta<MatrizEsparsaHashDup>(base, l.t_set, l.m_set, l.t_get, l.l_set, l.l_get);
+            else if (e == Estrutura::CAMADAS)
+                medirInsercaoConsulta<MatrizEmCamadas>(base, l.t_set, l.m_set, l.t_get, l.l_set, l.l_get);
+            else if (e == Estrutura::FRAGMENTADA)
+                medirInsercaoConsulta<MatrizEsparsaHashFragmentada>(base, l.t_set, l.m_set, l.t_get, l.l_set, l.l_get);
+            else
+                medirInsercaoConsulta<MatrizEsparsaTreeDup>(base, l.t_set, l.m_set, l.t_get, l.l_set, l.l_get);
+        }
+        if (usaOp("SET"))
+            for (auto& l : linhas) emitir("SET", l->e, l->t_set, l->m_set, base.size(), &l->l_set);
+        if (usaOp("GET"))   // memoria do GET e 0
+            for (auto& l : linhas) emitir("GET", l->e, l->t_get, 0, base.size(), &l->l_get);
+    }
+
+    //TRANSPOSTA
+    void transposta() {
+        vector<Entry> base = gerar();
+        paraCadaEstrutura("TRANS", base.size(), c_.limiteDensa, [&](Estrutura e, Medicao& t, long long& mem) {
+            if (e == Estrutura::DENSA) {
+                MatrizDensa A = montar<MatrizDensa>(base);
+                t = medir([&]() { return A.transposta(); }, &mem);
+            } else if (e == Estrutura::HASH) {
+                MatrizEsparsaHashDup A = montar<MatrizEsparsaHashDup>(base);
+                t = medir([&]() { A.transpor(); }, &mem);
+            } else if (e == Estrutura::TREE) {
+                MatrizEsparsaTreeDup A = montar<MatrizEsparsaTreeDup>(base);
+                t = medir([&]() { A.transpor(); }, &mem);
+            } else {
+                return false;
+            }
+            return true;
+        });
+    }
+
+    // Compara a transposta materializada (ordenacao por contagem em paralelo)
+    // com o transpor() O(1) das estruturas duplicadas: o tempo aqui e o de
+    // construir a outra orientacao e a memoria e a da orientacao nova. A linha
+    // CSR mostra o custo de quem guarda uma orientacao so.
+    void transpostaExplicita() {
+        vector<Entry> base = gerar();
+        paraCadaEstrutura("TRANS_EXPL", base.size(), c_.limiteDensa, [&](Estrutura e, Medicao& t, long long& mem) {
+            if (e == Estrutura::CAMADAS || e == Estrutura::FRAGMENTADA) return false;
+            if (e == Estrutura::DENSA) {
+                MatrizDensa A = montar<MatrizDensa>(base);
+                t = medir([&]() { return A.transposta(); }, &mem);
+            } else if (e == Estrutura::HASH) {
+                MatrizEsparsaHashDup A = montar<MatrizEsparsaHashDup>(base);
+                t = medir([&]() { return A.transpostaExplicita(); }, &mem);
+            } else if (e == Estrutura::TREE) {
+                MatrizEsparsaTreeDup A = montar<MatrizEsparsaTreeDup>(base);
+                t = medir([&]() { return A.transpostaExplicita(); }, &mem);
+            } else {
+                MatrizCSR C = montar<MatrizEsparsaHashDup>(base).paraCSR();
+                t = medir([&]() { return C.transposta(); }, &mem);
+            }
+            return true;
+        });
+    }
+
+    //SOMA / MULTIPLICACAO
+    template <typename Matriz, typename Op>
+    Medicao medirBinaria(const vector<Entry>& baseA, const vector<Entry>& baseB, long long& mem, Op op) {
+        Matriz A = montar<Matriz>(baseA), B = montar<Matriz>(baseB);
+        return medir([&]() { return op(A, B); }, &mem);
+    }
+
+    // CSR e Camadas usam os kernels da CSR (intercalacao / Gustavson); nas
+    // Camadas a compactacao das escritas de montar() fica na primeira execucao
+    void soma() {
+        vector<Entry> baseA = gerar(), baseB = gerar();
+        auto op = [](const auto& A, const auto& B) { return A.somar(B); };
+        paraCadaEstrutura("SOMA", baseA.size(), c_.limiteDensa, [&](Estrutura e, Medicao& t, long long& mem) {
+            if (e == Estrutura::DENSA) t = medirBinaria<MatrizDensa>(baseA, baseB, mem, op);
+            else if (e == Estrutura::HASH) t = medirBinaria<MatrizEsparsaHashDup>(baseA, baseB, mem, op);
+            else if (e == Estrutura::TREE) t = medirBinaria<MatrizEsparsaTreeDup>(baseA, baseB, mem, op);
+            else if (e == Estrutura::CAMADAS) t = medirBinaria<MatrizEmCamadas>(baseA, baseB, mem, op);
+            else if (e == Estrutura::FRAGMENTADA) t = medirBinaria<MatrizEsparsaHashFragmentada>(baseA, baseB, mem, op);
+            else {
+                MatrizCSR A = montar<MatrizEsparsaHashDup>(baseA).paraCSR(), B = montar<MatrizEsparsaHashDup>(baseB).paraCSR();
+                t = medir([&]() { return A.somar(B); }, &mem);
+            }
+            return true;
+        });
+    }
+
+    // Produto elemento a elemento (intercalacao das linhas ordenadas)
+    void hadamard() {
+        vector<Entry> baseA = gerar(), baseB = gerar();
+        auto op = [](const auto& A, const auto& B) { return A.produtoHadamard(B); };
+        paraCadaEstrutura("HADAMARD", baseA.size(), c_.limiteDensa, [&](Estrutura e, Medicao& t, long long& mem) {
+            if (e == Estrutura::CAMADAS || e == Estrutura::FRAGMENTADA) return false;
+            if (e == Estrutura::DENSA) t = medirBinaria<MatrizDensa>(baseA, baseB, mem, op);
+            else if (e == Estrutura::HASH) t = medirBinaria<MatrizEsparsaHashDup>(baseA, baseB, mem, op);
+            else if (e == Estrutura::TREE) t = medirBinaria<MatrizEsparsaTreeDup>(baseA, baseB, mem, op);
+            else {
+                MatrizCSR A = montar<MatrizEsparsaHashDup>(baseA).paraCSR(), B = montar<MatrizEsparsaHashDup>(baseB).paraCSR();
+                t = medir([&]() { return A.produtoHadamard(B); }, &mem);
+            }
+            return true;
+        });
+    }
+
+    void multiplicacao() {
+        vector<Entry> baseA = gerar(), baseB = gerar();
+        auto op = [](const auto& A, const auto& B) { return A.multiplicar(B); };
+        paraCadaEstrutura("MULT", baseA.size(), c_.limiteDensaMult, [&](Estrutura e, Medicao& t, long long& mem) {
+            if (e == Estrutura::DENSA) t = medirBinaria<MatrizDensa>(baseA, baseB, mem, op);
+            else if (e == Estrutura::HASH) t = medirBinaria<MatrizEsparsaHashDup>(baseA, baseB, mem, op);
+            else if (e == Estrutura::TREE) t = medirBinaria<MatrizEsparsaTreeDup>(baseA, baseB, mem, op);
+            else if (e == Estrutura::CAMADAS) t = medirBinaria<MatrizEmCamadas>(baseA, baseB, mem, op);
+            else if (e == Estrutura::FRAGMENTADA) t = medirBinaria<MatrizEsparsaHashFragmentada>(baseA, baseB, mem, op);
+            else {
+                MatrizCSR A = montar<MatrizEsparsaHashDup>(baseA).paraCSR(), B = montar<MatrizEsparsaHashDup>(baseB).paraCSR();
+                t = medir([&]() { return A.multiplicar(B); }, &mem);
+            }
+            return true;
+        });
+    }
+
+    //ESCALAR
+    // Em place: as repeticoes multiplicam a mesma matriz de novo, o custo por
+    // elemento nao muda
+    void escalar() {
+        double escalar = 3.14;
+        vector<Entry> base = gerar();
+        paraCadaEstrutura("ESCALAR", base.size(), c_.limiteDensa, [&](Estrutura e, Medicao& t, long long& mem) {
+            if (e == Estrutura::DENSA) {
+                MatrizDensa A = montar<MatrizDensa>(base);
+                t = medir([&]() { A.multiplicarEscalarInPlace(escalar); }, &mem);
+            } else if (e == Estrutura::HASH) {
+                MatrizEsparsaHashDup A = montar<MatrizEsparsaHashDup>(base);
+                t = medir([&]() { A.multiplicarEscalar(escalar); }, &mem);
+            } else if (e == Estrutura::TREE) {
+                MatrizEsparsaTreeDup A = montar<MatrizEsparsaTreeDup>(base);
+                t = medir([&]() { A.multiplicarEscalar(escalar); }, &mem);
+            } else if (e == Estrutura::FRAGMENTADA) {
+                MatrizEsparsaHashFragmentada A = montar<MatrizEsparsaHashFragmentada>(base);
+                t = medir([&]() { A.multiplicarEscalar(escalar); }, &mem);
+            } else {
+                return false;
+            }
+            return true;
+        });
+    }
+
+    //SPMV
+    // y = A * x com x fixo pela semente; a CSR sai da Hash fora do relogio
+    void spmv() {
+        vector<Entry> base = gerar();
+        vector<double> x(p_.dimensao);
+        for (long long j = 0; j < p_.dimensao; ++j) x[j] = (double)(aleatorioContador(p_.semente, j) % 100 + 1);
+        paraCadaEstrutura("SPMV", base.size(), c_.limiteDensa, [&](Estrutura e, Medicao& t, long long& mem) {
+            if (e == Estrutura::CAMADAS || e == Estrutura::FRAGMENTADA) return false;
+            if (e == Estrutura::DENSA) {
+                MatrizDensa A = montar<MatrizDensa>(base);
+                t = medir([&]() { return A.multiplicarVetor(x); }, &mem);
+            } else if (e == Estrutura::HASH) {
+                MatrizEsparsaHashDup A = montar<MatrizEsparsaHashDup>(base);
+                t = medir([&]() { return A.multiplicarVetor(x); }, &mem);
+            } else if (e == Estrutura::TREE) {
+                MatrizEsparsaTreeDup A = montar<MatrizEsparsaTreeDup>(base);
+                t = medir([&]() { return A.multiplicarVetor(x); }, &mem);
+            } else {
+                MatrizCSR C = montar<MatrizEsparsaHashDup>(base).paraCSR();
+                t = medir([&]() { return C.multiplicarVetor(x); }, &mem);
+            }
+            return true;
+        });
+    }
+
+    //SPMM
+    // A (esparsa, N x N) vezes um bloco denso N x LARGURA_SPMM, como uma
+    // matriz de atributos; a linha Densa e o produto denso comum
+    static const int LARGURA_SPMM = 64;
+
+    void spmm() {
+        vector<Entry> base = gerar();
+        long long n = p_.dimensao;
+        // o bloco denso nao passa do tamanho da maior densa permitida
+        if ((double)n * LARGURA_SPMM > (double)c_.limiteDensa * (double)c_.limiteDensa) return;
+        MatrizDensa X((int)n, LARGURA_SPMM);
+        for (long long i = 0; i < n; ++i)
+            for (int j = 0; j < LARGURA_SPMM; ++j)
+                X.set((int)i, j, (double)(aleatorioContador(p_.semente, i * LARGURA_SPMM + j) % 100 + 1));
+        paraCadaEstrutura("SPMM", base.size(), c_.limiteDensaMult, [&](Estrutura e, Medicao& t, long long& mem) {
+            if (e == Estrutura::CAMADAS || e == Estrutura::FRAGMENTADA) return false;
+            if (e == Estrutura::DENSA) {
+                MatrizDensa A = montar<MatrizDensa>(base);
+                t = medir([&]() { return A.multiplicar(X); }, &mem);
+            } else if (e == Estrutura::HASH) {
+                MatrizEsparsaHashDup A = montar<MatrizEsparsaHashDup>(base);
+                t = medir([&]() { return multiplicarEsparsaDensa(A, X); }, &mem);
+            } else if (e == Estrutura::TREE) {
+                MatrizEsparsaTreeDup A = montar<MatrizEsparsaTreeDup>(base);
+                t = medir([&]() { return multiplicarEsparsaDensa(A, X); }, &mem);
+            } else {
+                MatrizCSR C = montar<MatrizEsparsaHashDup>(base).paraCSR();
+                t = medir([&]() { return multiplicarEsparsaDensa(C, X); }, &mem);
+            }
+            return true;
+        });
+    }
+
+    //GEMM
+    // Produto de duas densas completas n x n, sempre na linha "Densa" (nao
+    // depende de --estruturas nem dos pontos da varredura). Sai uma vez por
+    // numero de threads, com k = n^2 e esparsidade 1.
+    void gemm(const string& chaveCarga) {
+        long long n = c_.dimGemm;
+        if (c_.escala == "fraca") n = max(1LL, llround((double)n * cbrt((double)numThreads())));
+        MatrizDensa A((int)n, (int)n), B((int)n, (int)n);
+        for (long long i = 0; i < n; ++i) {
+            for (long long j = 0; j < n; ++j) {
+                A.set((int)i, (int)j, (double)(aleatorioContador(p_.semente, i * n + j) % 100 + 1));
+                B.set((int)i, (int)j, (double)(aleatorioContador(p_.semente + 1, i * n + j) % 100 + 1));
+            }
+        }
+        p_.dimensao = n;
+        p_.k = n * n;
+        p_.esparsidade = 1.0;
+        p_.chaveBase = chaveCarga + "|gemm|" + to_string(c_.dimGemm);
+        cerr << "[benchmark] GEMM n=" << n << " threads=" << numThreads() << endl;
+        long long mem = 0;
+        Medicao t = medir([&]() { return A.multiplicar(B); }, &mem);
+        emitir("GEMM", Estrutura::DENSA, t, mem, (size_t)(n * n));
+    }
+
+    void executarPonto() {
+        bool insercaoFeita = false;
+        for (const string& op : c_.ops) {
+            if (op == "CONSTRUCAO") construcao();
+            else if (op == "TRANS") transposta();
+            else if (op == "TRANS_EXPL") transpostaExplicita();
+            else if (op == "SOMA") soma();
+            else if (op == "MULT") multiplicacao();
+            else if (op == "ESCALAR") escalar();
+            else if (op == "SPMV") spmv();
+            else if (op == "HADAMARD") hadamard();
+            else if (op == "SPMM") spmm();
+            else if ((op == "SET" || op == "GET") && !insercaoFeita) {
+                insercaoConsulta();   // SET e GET saem da mesma medicao
+                insercaoFeita = true;
+            }
+        }
+    }
+
+public:
+    SuiteBenchmark(const ConfigSuite& c, Relatorio& rel) : c_(c), rel_(rel), p_() {}
+
+    void executar() {
+        vector<int> threads = c_.threads;
+        if (threads.empty()) threads.push_back(threadsConfiguradas());
+        // com a CPU fixada (MC458_CPU) todas as threads dividem um nucleo
+        if (getenv("MC458_CPU") && *max_element(threads.begin(), threads.end()) != 1)
+            cerr << "[benchmark] aviso: MC458_CPU fixa o processo num nucleo, a escalabilidade nao vale" << endl;
+        bool fraca = c_.escala == "fraca";
+
+        for (uint64_t semente : c_.sementes) {
+            for (TipoCarga carga : c_.cargas) {
+                cargaAtual() = carga;
+                for (int t : threads) {
+                    definirNumThreads(t);
+                    // mesmas matrizes para todos os numeros de threads
+                    definir_semente(semente);
+                    p_.semente = semente;
+                    string chaveCarga = string(nomeCarga(carga)) + "|" + to_string(semente);
+                    int p = numThreads();
+
+                    for (long long dim : c_.dims) {
+                        double total = (double)dim * (double)dim;
+                        p_.dimensao = dim;
+                        p_.porK = !c_.ks.empty();
+                        if (p_.porK) {
+                            long long capacidade = capacidadeCarga(carga, dim, parametrosCarga());
+                            for (long long kBase : c_.ks) {
+                                long long k = fraca ? kBase * p : kBase;
+                                if (k > capacidade) break;
+                                p_.k = k;
+                                p_.chaveBase = chaveCarga + "|" + to_string(dim) + "|k" + to_string(kBase);
+                                p_.esparsidade = (double)k / total;
+                                cerr << "[benchmark] " << nomeCarga(carga) << " N=" << dim << " k=" << k
+                                     << " threads=" << numThreads() << endl;
+                                executarPonto();
+                            }
+                        } else {
+                            vector<double> esps = c_.esparsidades.empty() ? esparsidadesDoProjeto(dim) : c_.esparsidades;
+                            for (double eBase : esps) {
+                                if (eBase <= 0.0) continue;
+                                double e = fraca ? min(1.0, eBase * p) : eBase;
+                                p_.esparsidade = e;
+                                p_.chaveBase = chaveCarga + "|" + to_string(dim) + "|e" + to_string(eBase);
+                                p_.k = llround(total * e);
+                                cerr << "[benchmark] " << nomeCarga(carga) << " N=" << dim << " esp=" << e
+                                     << " threads=" << numThreads() << endl;
+                                executarPonto();
+                            }
+                        }
+                    }
+                    if (usaOp("GEMM")) gemm(chaveCarga);
+                }
+            }
+        }
+    }
+};
+
+// Comparacao com o baseline; devolve o codigo de saida (3 = piorou)
+inline int compararComBaseline(const ConfigSuite& config, const TabelaTempos& atual, ostream& padrao) {
+    TabelaTempos base;
+    if (!lerTabelaCSV(config.baseline, base)) return 1;
+    ofstream arquivo;
+    if (!config.saidaComparacao.empty()) {
+        arquivo.open(config.saidaComparacao);
+        if (!arquivo) {
+            cerr << "nao foi possivel abrir " << config.saidaComparacao << endl;
+            return 1;
+        }
+    }
+    int lentos = compararTabelas(atual, base, config.comparacao, arquivo.is_open() ? arquivo : padrao);
+    return lentos > 0 ? 3 : 0;
+}
+
+// main dos executaveis de benchmark: preset (vazio = padroes da suite),
+// depois a linha de comando
+inline int executarSuite(int argc, char** argv, const string& preset = "") {
+    ios::sync_with_stdio(false);
+    cin.tie(nullptr);
+
+    configurarMedicao();
+    ConfigSuite config;
+    if (!preset.empty()) aplicarPreset(preset, config);
+    if (!lerLinhaDeComando(argc, argv, config)) return 2;
+
+    if (!config.comparar.empty()) {
+        TabelaTempos atual;
+        if (!lerTabelaCSV(config.comparar, atual)) return 1;
+        return compararComBaseline(config, atual, cout);
+    }
+
+    Relatorio rel;
+    if (!rel.abrir(config.formato, config.saida, coletarAmbiente(argc, argv), config.ks.empty() ? "N" : "k"))
+        return 1;
+    SuiteBenchmark(config, rel).executar();
+    rel.fechar();
+
+    imprimir_memoria_processo(cerr);
+    if (config.baseline.empty()) return 0;
+    return compararComBaseline(config, tabelaDeResultados(rel.resultados(), rel.colunaTamanho()), cerr);
+}
@@ -0,0 +1,12 @@
+#include "suite.h"
+
+using namespace std;
+
+// Escalabilidade em numero de threads: CONSTRUCAO, SOMA, MULT, SPMV e GEMM
+// denso com 1, 2, 4, ... ate todos os nucleos (preset "escalabilidade").
+// --escala=fraca faz o problema crescer com as threads; a coluna Eficiencia
+// e a que analise/plot_escalabilidade.py desenha.
+// uso: test_escalabilidade [cargas...] [--escala=forte|fraca] [opcoes]
+int main(int argc, char** argv) {
+    return executarSuite(argc, argv, "escalabilidade");
+}
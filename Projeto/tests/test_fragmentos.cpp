@@ -0,0 +1,12 @@
+#include "suite.h"
+
+using namespace std;
+
+// Hash sequencial contra a Hash fragmentada por linhas (fragmentada.h):
+// CONSTRUCAO, SOMA, MULT e SPMV com 1, 2, 4, ... ate todos os nucleos
+// (preset "fragmentos"). A fragmentada tem um fragmento por thread, entao a
+// coluna Eficiencia mostra o ganho da construcao e da soma sem trava.
+// uso: test_fragmentos [cargas...] [opcoes]
+int main(int argc, char** argv) {
+    return executarSuite(argc, argv, "fragmentos");
+}
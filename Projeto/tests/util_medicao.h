@@ -1,55 +1,189 @@
+#pragma once
 #include <chrono>
 #include <fstream>
+#include <string>
 #include <unistd.h>
 #include <atomic>
 #include <new>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
 
 using namespace std;
 
-static atomic<long long> allocated_bytes(0);
-static thread_local bool track_alloc = false;
+/*
+    -------------
+    [CONTABILIDADE DE MEMORIA]
+    -------------
+    Todas as formas de new/delete (simples, array, com tamanho, alinhadas e
+    nothrow) sao substituidas. Cada bloco leva um cabecalho com o tamanho
+    pedido, entao o delete desconta exatamente o que o new somou, de
+    qualquer thread (os kernels paralelos alocam nas threads deles).
+
+    Contadores globais: bytes vivos, pico de bytes vivos e total alocado.
+    start_tracking() abre um escopo de medicao e stop_tracking() fecha:
+      get_tracked_bytes()   pico de bytes vivos acima do inicio do escopo
+                            (o "quanto de memoria a operacao precisou")
+      get_live_bytes()      bytes que continuam vivos (ex.: o resultado)
+      get_allocated_bytes() soma de tudo que foi alocado no escopo
+    Um escopo por vez; start_tracking() com um escopo aberto recomeca ele.
+    Os numeros sao de bytes pedidos: o RSS do /proc (get_rss_bytes) serve
+    de conferencia e inclui cabecalhos, sobra do malloc e paginas do SO.
+
+    Este arquivo define os operadores globais: so pode ser incluido por um
+    .cpp de cada executavel (como os testes ja fazem).
+*/
+
+static atomic<long long> bytes_vivos(0);
+static atomic<long long> pico_vivos(0);
+static atomic<long long> bytes_alocados(0);
+
+struct EscopoMemoria {
+    bool ativo = false;
+    long long baseVivos = 0, baseAlocados = 0;
+    long long picoAntes = 0;   // pico global de antes do escopo (restaurado no fim)
+    long long pico = 0, vivos = 0, alocados = 0;   // resultados do ultimo escopo fechado
+};
+
+static EscopoMemoria escopo_memoria;
 
 void start_tracking() {
-    allocated_bytes = 0;
-    track_alloc = true;
+    EscopoMemoria& e = escopo_memoria;
+    long long agora = bytes_vivos.load();
+    if (!e.ativo) e.picoAntes = pico_vivos.load();
+    else e.picoAntes = max(e.picoAntes, pico_vivos.load());
+    e.baseVivos = agora;
+    e.baseAlocados = bytes_alocados.load();
+    pico_vivos = agora;
+    e.ativo = true;
 }
 
 void stop_tracking() {
-    track_alloc = false;
+    EscopoMemoria& e = escopo_memoria;
+    if (!e.ativo) return;
+    long long p = pico_vivos.load();
+    e.pico = p - e.baseVivos;
+    e.vivos = bytes_vivos.load() - e.baseVivos;
+    e.alocados = bytes_alocados.load() - e.baseAlocados;
+    if (e.picoAntes > p) pico_vivos = e.picoAntes;
+    e.ativo = false;
 }
 
 long long get_tracked_bytes() {
-    return allocated_bytes.load();
+    const EscopoMemoria& e = escopo_memoria;
+    return e.ativo ? pico_vivos.load() - e.baseVivos : e.pico;
+}
+
+long long get_live_bytes() {
+    const EscopoMemoria& e = escopo_memoria;
+    return e.ativo ? bytes_vivos.load() - e.baseVivos : e.vivos;
+}
+
+long long get_allocated_bytes() {
+    const EscopoMemoria& e = escopo_memoria;
+    return e.ativo ? bytes_alocados.load() - e.baseAlocados : e.alocados;
+}
+
+// Totais do processo
+long long get_process_live_bytes() { return bytes_vivos.load(); }
+long long get_process_peak_bytes() { return max(pico_vivos.load(), escopo_memoria.picoAntes); }
+
+// Campo em kB de /proc/self/status ("VmRSS", "VmHWM"), em bytes; -1 se nao houver
+long long ler_proc_status(const string& campo) {
+    ifstream f("/proc/self/status");
+    string linha;
+    while (getline(f, linha)) {
+        if (linha.compare(0, campo.size(), campo) == 0 && linha.size() > campo.size() && linha[campo.size()] == ':')
+            return atoll(linha.c_str() + campo.size() + 1) * 1024;
+    }
+    return -1;
+}
+
+long long get_rss_bytes() { return ler_proc_status("VmRSS"); }
+long long get_peak_rss_bytes() { return ler_proc_status("VmHWM"); }
+
+// Conferencia no fim dos testes: contagem propria x RSS do SO
+template <typename Saida>
+void imprimir_memoria_processo(Saida& out) {
+    out << "memoria: vivos=" << get_process_live_bytes()
+        << " pico=" << get_process_peak_bytes()
+        << " VmRSS=" << get_rss_bytes()
+        << " VmHWM=" << get_peak_rss_bytes() << endl;
 }
 
-void* operator new(std::size_t sz) {
-    if (track_alloc) allocated_bytes += sz;
-    void* ptr = std::malloc(sz);
-    if (!ptr) throw std::bad_alloc();
-    return ptr;
+//ALOCACAO COM CABECALHO
+// [sobra de alinhamento][CabecalhoAlocacao][bloco do usuario]
+struct CabecalhoAlocacao {
+    void* base;          // ponteiro devolvido pelo malloc
+    long long tamanho;   // bytes pedidos
+};
+
+static_assert(sizeof(CabecalhoAlocacao) == 16, "cabecalho deve preservar o alinhamento de 16");
+
+inline void* alocar_rastreado(size_t sz, size_t alinhamento) {
+    if (alinhamento < alignof(max_align_t)) alinhamento = alignof(max_align_t);
+    size_t extra = sizeof(CabecalhoAlocacao) + alinhamento - 1;
+    void* base = malloc(sz + extra);
+    if (!base) return nullptr;
+
+    uintptr_t u = ((uintptr_t)base + sizeof(CabecalhoAlocacao) + alinhamento - 1) & ~(uintptr_t)(alinhamento - 1);
+    CabecalhoAlocacao* c = (CabecalhoAlocacao*)u - 1;
+    c->base = base;
+    c->tamanho = (long long)sz;
+
+    long long v = bytes_vivos.fetch_add((long long)sz, memory_order_relaxed) + (long long)sz;
+    bytes_alocados.fetch_add((long long)sz, memory_order_relaxed);
+    long long p = pico_vivos.load(memory_order_relaxed);
+    while (v > p && !pico_vivos.compare_exchange_weak(p, v, memory_order_relaxed)) {}
+    return (void*)u;
 }
 
-void* operator new[](std::size_t sz) {
-    if (track_alloc) allocated_bytes += sz;
-    void* ptr = std::malloc(sz);
-    if (!ptr) throw std::bad_alloc();
-    return ptr;
+inline void liberar_rastreado(void* ptr) noexcept {
+    if (!ptr) return;
+    CabecalhoAlocacao* c = (CabecalhoAlocacao*)ptr - 1;
+    bytes_vivos.fetch_sub(c->tamanho, memory_order_relaxed);
+    free(c->base);
 }
 
-void operator delete(void* ptr) noexcept {
-    free(ptr);
+inline void* alocar_ou_lancar(size_t sz, size_t alinhamento) {
+    void* p = alocar_rastreado(sz, alinhamento);
+    if (!p) throw std::bad_alloc();
+    return p;
 }
 
+void* operator new(size_t sz) { return alocar_ou_lancar(sz, 0); }
+void* operator new[](size_t sz) { return alocar_ou_lancar(sz, 0); }
+void* operator new(size_t sz, align_val_t al) { return alocar_ou_lancar(sz, (size_t)al); }
+void* operator new[](size_t sz, align_val_t al) { return alocar_ou_lancar(sz, (size_t)al); }
+void* operator new(size_t sz, const nothrow_t&) noexcept { return alocar_rastreado(sz, 0); }
+void* operator new[](size_t sz, const nothrow_t&) noexcept { return alocar_rastreado(sz, 0); }
+void* operator new(size_t sz, align_val_t al, const nothrow_t&) noexcept { return alocar_rastreado(sz, (size_t)al); }
+void* operator new[](size_t sz, align_val_t al, const nothrow_t&) noexcept { return alocar_rastreado(sz, (size_t)al); }
+
+void operator delete(void* ptr) noexcept { liberar_rastreado(ptr); }
+void operator delete[](void* ptr) noexcept { liberar_rastreado(ptr); }
+void operator delete(void* ptr, size_t) noexcept { liberar_rastreado(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { liberar_rastreado(ptr); }
+void operator delete(void* ptr, align_val_t) noexcept { liberar_rastreado(ptr); }
+void operator delete[](void* ptr, align_val_t) noexcept { liberar_rastreado(ptr); }
+void operator delete(void* ptr, size_t, align_val_t) noexcept { liberar_rastreado(ptr); }
+void operator delete[](void* ptr, size_t, align_val_t) noexcept { liberar_rastreado(ptr); }
+void operator delete(void* ptr, const nothrow_t&) noexcept { liberar_rastreado(ptr); }
+void operator delete[](void* ptr, const nothrow_t&) noexcept { liberar_rastreado(ptr); }
+void operator delete(void* ptr, align_val_t, const nothrow_t&) noexcept { liberar_rastreado(ptr); }
+void operator delete[](void* ptr, align_val_t, const nothrow_t&) noexcept { liberar_rastreado(ptr); }
+
 
 struct Cronometro {
-    chrono::high_resolution_clock::time_point inicio;
+    chrono::steady_clock::time_point inicio;
 
     void comecar() {
-        inicio = chrono::high_resolution_clock::now();
+        inicio = chrono::steady_clock::now();
     }
 
     long long finalizar() {
-        auto fim = chrono::high_resolution_clock::now();
+        auto fim = chrono::steady_clock::now();
         return chrono::duration_cast<chrono::nanoseconds>(fim - inicio).count();
     }
 };
@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+#include <ostream>
+using namespace std;
+
+/*
+    -------------
+    [USO DE MEMORIA DAS MATRIZES]
+    -------------
+    Quanto cada parte de uma matriz ocupa, calculado a partir dos tamanhos e
+    capacidades dos containers (O(1), ou O(blocos do pool)), sem percorrer
+    os elementos -- pode ser chamado a qualquer momento, para monitorar ou
+    para escolher o formato.
+
+    Os nos de std::map e std::unordered_map nao sao visiveis, entao o tamanho
+    deles e estimado pelo layout usual (libstdc++/libc++): arvore = 3
+    ponteiros + cor (uma palavra, por causa do alinhamento) + valor; tabela
+    hash = ponteiro do proximo + valor (sem o hash guardado, que as chaves
+    inteiras nao usam). A sobra do malloc por alocacao nao entra; o contador
+    de tests/util_medicao.h serve de conferencia.
+*/
+
+struct UsoMemoria {
+    size_t nos = 0;              // blocos do pool de nos (inclui os slots livres)
+    size_t nosVivos = 0;
+    size_t nosLivres = 0;        // slots entregues e devolvidos, esperando reuso
+    size_t tabelas = 0;          // baldes + nos das tabelas hash
+    size_t baldesIJ = 0, baldesJI = 0;
+    double fatorCargaIJ = 0, fatorCargaJI = 0;
+    size_t cabecas = 0;          // vetores O(dimensao): cabecas de lista e contadores
+    size_t arvores = 0;          // nos das arvores (std::map)
+    size_t contiguo = 0;         // vetores de valores/indices (densa, CSR)
+    size_t valores = 0;          // carga util: nnz * sizeof(double), ja contada acima
+    size_t objeto = 0;           // sizeof da classe
+
+    size_t total() const { return objeto + nos + tabelas + cabecas + arvores + contiguo; }
+
+    // fracao do total que e valor de fato
+    double aproveitamento() const { return total() ? (double)valores / (double)total() : 0.0; }
+};
+
+inline ostream& operator<<(ostream& out, const UsoMemoria& u) {
+    out << "total=" << u.total() << " nos=" << u.nos << " (vivos=" << u.nosVivos << " livres=" << u.nosLivres << ")"
+        << " tabelas=" << u.tabelas << " (baldes=" << u.baldesIJ << "/" << u.baldesJI
+        << " carga=" << u.fatorCargaIJ << "/" << u.fatorCargaJI << ")"
+        << " cabecas=" << u.cabecas << " arvores=" << u.arvores << " contiguo=" << u.contiguo
+        << " valores=" << u.valores;
+    return out;
+}
+
+template <typename T>
+inline size_t bytesVetor(const vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+template <typename K, typename V>
+inline size_t bytesTabelaHash(const unordered_map<K, V>& t) {
+    return t.bucket_count() * sizeof(void*) + t.size() * (sizeof(void*) + sizeof(pair<const K, V>));
+}
+
+template <typename K, typename V>
+inline size_t bytesNoArvore() {
+    return 4 * sizeof(void*) + sizeof(pair<const K, V>);
+}
+
+// Arvore de arvores (mapa externo por linha, internos por coluna): os nos
+// internos somados sao o nnz, os externos sao as linhas nao vazias
+template <typename K, typename V>
+inline size_t bytesArvoreDupla(const map<K, map<K, V>>& m, size_t nosInternos) {
+    return m.size() * bytesNoArvore<K, map<K, V>>() + nosInternos * bytesNoArvore<K, V>();
+}
@@ -0,0 +1,324 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include "csr.h"
+#include "produto_esparso.h"
+#include "paralelo.h"
+using namespace std;
+
+/*
+    -------------
+    [VISOES DE SUBMATRIZES (SEM COPIA)]
+    -------------
+    VisaoMatriz<M> aponta para uma matriz M (HashDup, TreeDup, CSR ou outra
+    visao) e escolhe linhas e colunas dela: uma faixa [ini, fim) ou um
+    conjunto qualquer de indices (na ordem dada, que vira a ordem da visao).
+    Nada dos elementos e copiado -- so os indices escolhidos -- entao a
+    matriz de origem precisa viver mais que a visao, e mudancas nela aparecem
+    na visao.
+    A visao e por linhas (usa paraCadaNaLinha da origem, na orientacao ativa)
+    e tem a mesma interface de leitura das esparsas: getElemento,
+    paraCadaNaLinha, paraCadaLinhaNaoVazia, paraCadaElemento, nnzNaLinha,
+    multiplicarVetor e paraCSR. Com isso ela entra direto no SpMM de
+    mistas.h e nos construtores em bloco (MatrizEsparsaHashDup(visao) copia
+    so a submatriz). O produto (multiplicar / multiplicarPorLinhas) aceita
+    visoes e matrizes dos dois lados.
+    Com colunas escolhidas cada linha da origem e percorrida inteira e
+    filtrada; a ordem das colunas dentro da linha e a da origem. Indices
+    repetidos valem: a linha/coluna aparece em cada posicao em que foi dada.
+    blocosDeLinhas(p) divide as linhas em p faixas com nnz parecido, para
+    processar uma matriz grande em paralelo por blocos.
+*/
+
+// Indices escolhidos de uma dimensao: faixa ou conjunto
+class SelecaoIndices {
+private:
+    bool faixa_ = true;
+    int inicio_ = 0, tamanho_ = 0;
+    vector<int> indices_;                   // conjunto: indice na origem de cada posicao
+    unordered_map<int, int> posicao_;       // conjunto: origem -> primeira posicao (so para colunas)
+    vector<int> proxima_;                   // proxima posicao com a mesma origem (-1 se nao ha)
+
+public:
+    SelecaoIndices() {}
+
+    static SelecaoIndices faixa(int ini, int fim) {
+        SelecaoIndices s;
+        s.inicio_ = ini;
+        s.tamanho_ = max(0, fim - ini);
+        return s;
+    }
+
+    // com inverso=true guarda origem -> posicoes (necessario para filtrar
+    // colunas); um indice repetido aparece em todas as posicoes em que foi dado
+    static SelecaoIndices conjunto(vector<int> indices, bool inverso) {
+        SelecaoIndices s;
+        s.faixa_ = false;
+        s.tamanho_ = (int)indices.size();
+        s.indices_ = std::move(indices);
+        if (inverso) {
+            s.posicao_.reserve(s.indices_.size());
+            s.proxima_.assign(s.indices_.size(), -1);
+            // de tras para frente: cada posicao encadeia a seguinte de mesma origem
+            for (int p = s.tamanho_ - 1; p >= 0; --p) {
+                auto it = s.posicao_.find(s.indices_[p]);
+                if (it == s.posicao_.end()) s.posicao_.emplace(s.indices_[p], p);
+                else {
+                    s.proxima_[p] = it->second;
+                    it->second = p;
+                }
+            }
+        }
+        return s;
+    }
+
+    bool eFaixa() const { return faixa_; }
+    int tamanho() const { return tamanho_; }
+
+    // indice na origem da posicao p da visao
+    int origem(int p) const { return faixa_ ? inicio_ + p : indices_[p]; }
+
+    // f(p) para cada posicao p da visao com o indice k da origem, crescentes
+    // (nenhuma se k nao foi escolhido)
+    template <typename F>
+    void paraCadaPosicao(int k, F f) const {
+        if (faixa_) {
+            if (k >= inicio_ && k < inicio_ + tamanho_) f(k - inicio_);
+            return;
+        }
+        auto it = posicao_.find(k);
+        if (it == posicao_.end()) return;
+        for (int p = it->second; p >= 0; p = proxima_[p]) f(p);
+    }
+
+    // posicoes [ini, fim) desta selecao
+    SelecaoIndices recorte(int ini, int fim, bool inverso) const {
+        if (faixa_) return faixa(inicio_ + ini, inicio_ + fim);
+        return conjunto(vector<int>(indices_.begin() + ini, indices_.begin() + fim), inverso);
+    }
+};
+
+// Produto C = A*B de quaisquer dois operandos com paraCadaNaLinha (matrizes
+// ou visoes), Gustavson por linhas de A em paralelo: cada linha e percorrida
+// duas vezes (padrao, valores), como em MatrizCSR::multiplicar. Cada thread
+// monta as suas linhas de C (faixa contigua) e no fim as faixas sao emendadas.
+template <typename MA, typename MB>
+MatrizCSR multiplicarPorLinhas(const MA& A, const MB& B) {
+    int L = A.getLinhas(), K = B.getLinhas(), N = B.getColunas();
+    long long trabalho = (long long)(A.getNaoNulos() + B.getNaoNulos());
+    int threads = max(1, threadsPara(trabalho, 1 << 14));
+    vector<long long> inicio((size_t)max(0, L) + 1, 0);
+    vector<vector<int>> colsThread(threads);
+    vector<vector<double>> valsThread(threads);
+    paraleloPara(L, threads, [&](long long ini, long long fim, int t) {
+        AcumuladorLinha acc(N, trabalho);
+        vector<int> colunas;
+        for (long long i = ini; i < fim; ++i) {
+            // padrao da linha, depois os valores (o acumulador so soma em colunas marcadas)
+            A.paraCadaNaLinha((int)i, [&](int k, double) {
+                if (k >= 0 && k < K) B.paraCadaNaLinha(k, [&](int j, double) { acc.marcar(j); });
+            });
+            colunas.clear();
+            acc.extrairColunas(colunas);
+            A.paraCadaNaLinha((int)i, [&](int k, double a) {
+                if (k >= 0 && k < K) B.paraCadaNaLinha(k, [&](int j, double b) { acc.somar(j, a * b); });
+            });
+            long long n = 0;
+            for (int j : colunas) {
+                double v = acc.retirar(j);
+                if (v == 0.0) continue;
+                colsThread[t].push_back(j);
+                valsThread[t].push_back(v);
+                ++n;
+            }
+            acc.limparValores();
+            inicio[i + 1] = n;
+        }
+    });
+    for (int i = 0; i < L; ++i) inicio[i + 1] += inicio[i];
+
+    // as faixas das threads ficam em ordem de linha: concatenar basta
+    vector<int> cols;
+    vector<double> vals;
+    cols.reserve((size_t)inicio[max(0, L)]);
+    vals.reserve((size_t)inicio[max(0, L)]);
+    for (int t = 0; t < threads; ++t) {
+        cols.insert(cols.end(), colsThread[t].begin(), colsThread[t].end());
+        vals.insert(vals.end(), valsThread[t].begin(), valsThread[t].end());
+    }
+    return MatrizCSR(L, N, std::move(inicio), std::move(cols), std::move(vals));
+}
+
+template <typename Matriz>
+class VisaoMatriz {
+private:
+    const Matriz* origem_;
+    SelecaoIndices linhas_, colunas_;
+    bool todasColunas_;
+
+public:
+    VisaoMatriz(const Matriz& origem, SelecaoIndices linhas, SelecaoIndices colunas)
+        : origem_(&origem), linhas_(std::move(linhas)), colunas_(std::move(colunas)),
+          todasColunas_(colunas_.eFaixa() && colunas_.origem(0) == 0 && colunas_.tamanho() == origem.getColunas()) {}
+
+    const Matriz& origem() const { return *origem_; }
+    int getLinhas() const { return linhas_.tamanho(); }
+    int getColunas() const { return colunas_.tamanho(); }
+
+    //ACESSAR ELEMENTO
+    double getElemento(int i, int j) const {
+        if (i < 0 || i >= getLinhas() || j < 0 || j >= getColunas()) return 0.0;
+        return origem_->getElemento(linhas_.origem(i), colunas_.origem(j));
+    }
+
+    //PERCORRER ELEMENTOS
+    // f(j, valor) para cada nao-nulo da linha i da visao
+    template <typename F>
+    void paraCadaNaLinha(int i, F f) const {
+        if (i < 0 || i >= getLinhas()) return;
+        if (todasColunas_) {
+            origem_->paraCadaNaLinha(linhas_.origem(i), f);
+            return;
+        }
+        origem_->paraCadaNaLinha(linhas_.origem(i), [&](int j, double v) {
+            colunas_.paraCadaPosicao(j, [&](int p) { f(p, v); });
+        });
+    }
+
+    int nnzNaLinha(int i) const {
+        if (i < 0 || i >= getLinhas()) return 0;
+        if (todasColunas_) return origem_->nnzNaLinha(linhas_.origem(i));
+        int n = 0;
+        paraCadaNaLinha(i, [&](int, double) { ++n; });
+        return n;
+    }
+
+    // f(i) para cada linha da visao com pelo menos um nao-nulo, em ordem
+    template <typename F>
+    void paraCadaLinhaNaoVazia(F f) const {
+        for (int i = 0; i < getLinhas(); ++i)
+            if (nnzNaLinha(i) > 0) f(i);
+    }
+
+    // f(i, j, valor) para todos os nao-nulos, linha a linha
+    template <typename F>
+    void paraCadaElemento(F f) const {
+        for (int i = 0; i < getLinhas(); ++i)
+            paraCadaNaLinha(i, [&](int j, double v) { f(i, j, v); });
+    }
+
+    // O(linhas da visao) sem colunas escolhidas, senao percorre as linhas
+    size_t getNaoNulos() const {
+        int threads = threadsPara(getLinhas(), 1 << 12);
+        return reduzirParalelo(getLinhas(), threads, (size_t)0,
+            [&](long long ini, long long fim) {
+                size_t n = 0;
+                for (long long i = ini; i < fim; ++i) n += (size_t)nnzNaLinha((int)i);
+                return n;
+            },
+            [](size_t a, size_t b) { return a + b; });
+    }
+
+    //RECORTES (continuam sem copia dos elementos)
+    VisaoMatriz linhas(int ini, int fim) const {
+        ini = max(0, ini);
+        fim = min(getLinhas(), fim);
+        return VisaoMatriz(*origem_, linhas_.recorte(ini, max(ini, fim), false), colunas_);
+    }
+
+    // ate `partes` faixas contiguas de linhas com nnz parecido (as vazias nao saem)
+    vector<VisaoMatriz> blocosDeLinhas(int partes) const {
+        int L = getLinhas();
+        vector<long long> acumulado((size_t)L + 1, 0);
+        paraleloPara(L, threadsPara(L, 1 << 12), [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) acumulado[i + 1] = nnzNaLinha((int)i);
+        });
+        for (int i = 0; i < L; ++i) acumulado[i + 1] += acumulado[i];
+
+        vector<VisaoMatriz> blocos;
+        partes = max(1, partes);
+        int ini = 0;
+        for (int b = 1; b <= partes && ini < L; ++b) {
+            long long alvo = acumulado[L] * b / partes;
+            int fim = b == partes ? L : (int)(upper_bound(acumulado.begin(), acumulado.end(), alvo) - acumulado.begin()) - 1;
+            fim = max(fim, ini + 1);
+            fim = min(fim, L);
+            blocos.push_back(linhas(ini, fim));
+            ini = fim;
+        }
+        return blocos;
+    }
+
+    //MULTIPLICACAO POR VETOR (SpMV): y = V*x, x com getColunas() posicoes
+    vector<double> multiplicarVetor(const vector<double>& x) const {
+        vector<double> y((size_t)getLinhas(), 0.0);
+        paraleloPara(getLinhas(), threadsPara(getLinhas(), 1 << 10), [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) {
+                double soma = 0.0;
+                paraCadaNaLinha((int)i, [&](int j, double v) { soma += v * x[j]; });
+                y[i] = soma;
+            }
+        });
+        return y;
+    }
+
+    //MULTIPLICACAO: B pode ser matriz ou visao
+    template <typename Outra>
+    MatrizCSR multiplicar(const Outra& B) const {
+        return multiplicarPorLinhas(*this, B);
+    }
+
+    //EXTRAIR (copia so a submatriz, em paralelo por faixas de linhas)
+    // Colunas ordenadas dentro de cada linha, como a CSR exige
+    MatrizCSR paraCSR() const {
+        int L = getLinhas();
+        vector<long long> inicio((size_t)L + 1, 0);
+        int threads = threadsPara(L, 1 << 10);
+        paraleloPara(L, threads, [&](long long ini, long long fim, int) {
+            for (long long i = ini; i < fim; ++i) inicio[i + 1] = nnzNaLinha((int)i);
+        });
+        for (int i = 0; i < L; ++i) inicio[i + 1] += inicio[i];
+
+        vector<int> cols((size_t)inicio[L]);
+        vector<double> vals((size_t)inicio[L]);
+        paraleloPara(L, threads, [&](long long ini, long long fim, int) {
+            vector<pair<int, double>> linha;
+            for (long long i = ini; i < fim; ++i) {
+                linha.clear();
+                paraCadaNaLinha((int)i, [&](int j, double v) { linha.push_back(make_pair(j, v)); });
+                sort(linha.begin(), linha.end());
+                long long d = inicio[i];
+                for (auto const& e : linha) {
+                    cols[d] = e.first;
+                    vals[d++] = e.second;
+                }
+            }
+        });
+        return MatrizCSR(L, getColunas(), std::move(inicio), std::move(cols), std::move(vals));
+    }
+};
+
+//CRIAR VISOES
+// linhas [ini, fim), todas as colunas
+template <typename Matriz>
+VisaoMatriz<Matriz> visaoLinhas(const Matriz& A, int ini, int fim) {
+    ini = max(0, ini);
+    fim = min(A.getLinhas(), fim);
+    return VisaoMatriz<Matriz>(A, SelecaoIndices::faixa(ini, max(ini, fim)), SelecaoIndices::faixa(0, A.getColunas()));
+}
+
+// colunas [ini, fim), todas as linhas
+template <typename Matriz>
+VisaoMatriz<Matriz> visaoColunas(const Matriz& A, int ini, int fim) {
+    ini = max(0, ini);
+    fim = min(A.getColunas(), fim);
+    return VisaoMatriz<Matriz>(A, SelecaoIndices::faixa(0, A.getLinhas()), SelecaoIndices::faixa(ini, max(ini, fim)));
+}
+
+// linhas e colunas quaisquer (indices da origem, na ordem em que vao aparecer)
+template <typename Matriz>
+VisaoMatriz<Matriz> visaoIndices(const Matriz& A, vector<int> linhas, vector<int> colunas) {
+    return VisaoMatriz<Matriz>(A, SelecaoIndices::conjunto(std::move(linhas), false),
+                               SelecaoIndices::conjunto(std::move(colunas), true));
+}